@@ -0,0 +1,259 @@
+#include "aggregate.h"
+#include "util.h"
+#include "buffer.h"
+#include "shard.h"
+#include "bplustree.h"
+#include "pagedtree.h"
+#include "hybrid.h"
+
+/**
+ * Set an aggregate to the aggregate over no entries.
+ * @param aggregate The aggregate
+ */
+void emptyAggregate(Aggregate *aggregate) {
+  aggregate->bytes = 0;
+  aggregate->valued = 0;
+  aggregate->sum = 0;
+  aggregate->min = 0;
+  aggregate->max = 0;
+  aggregate->minCount = 0;
+  aggregate->maxCount = 0;
+}
+
+/**
+ * Parse the numeric payload of an entry: the number at the start of its description, followed by a space or the
+ * end of the description (e.g. "42.5 cpu load").
+ * @param description The description of the entry
+ * @param payload Set to the payload
+ * @return 1 if the entry has a payload, 0 otherwise
+ */
+int entryPayload(char *description, double *payload) {
+  char first = description[0];
+  if ((first < '0' || first > '9') && first != '-' && first != '+' && first != '.') {
+    return 0;
+  }
+  char *end;
+  double value = strtod(description, &end);
+  if (end == description || (*end != '\0' && *end != ' ') || !isfinite(value)) {
+    return 0;
+  }
+  *payload = value;
+  return 1;
+}
+
+/**
+ * Add an entry to an aggregate.
+ * @param aggregate The aggregate
+ * @param description The description of the entry
+ */
+void addEntryToAggregate(Aggregate *aggregate, char *description) {
+  aggregate->bytes += (long long) strlen(description);
+  double payload;
+  if (!entryPayload(description, &payload)) {
+    return;
+  }
+  if (aggregate->valued == 0 || payload < aggregate->min) {
+    aggregate->min = payload;
+    aggregate->minCount = 1;
+  } else if (payload == aggregate->min) {
+    aggregate->minCount++;
+  }
+  if (aggregate->valued == 0 || payload > aggregate->max) {
+    aggregate->max = payload;
+    aggregate->maxCount = 1;
+  } else if (payload == aggregate->max) {
+    aggregate->maxCount++;
+  }
+  aggregate->valued++;
+  aggregate->sum += payload;
+}
+
+/**
+ * Take an entry out of an aggregate. The smallest or largest payload can't be taken out once its last entry is gone,
+ * then the aggregate has to be recalculated.
+ * @param aggregate The aggregate
+ * @param description The description of the entry
+ * @return 1 if the aggregate is up to date, 0 if it has to be recalculated
+ */
+int removeEntryFromAggregate(Aggregate *aggregate, char *description) {
+  aggregate->bytes -= (long long) strlen(description);
+  double payload;
+  if (!entryPayload(description, &payload)) {
+    return 1;
+  }
+  if (--aggregate->valued == 0) {
+    // No payloads are left, rounding errors of the sum don't stay behind
+    aggregate->sum = 0;
+    aggregate->min = 0;
+    aggregate->max = 0;
+    aggregate->minCount = 0;
+    aggregate->maxCount = 0;
+    return 1;
+  }
+  aggregate->sum -= payload;
+  if (payload == aggregate->min && --aggregate->minCount == 0) {
+    return 0;
+  }
+  if (payload == aggregate->max && --aggregate->maxCount == 0) {
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Add the entries of an aggregate to another one.
+ * @param into The aggregate that is extended
+ * @param from The aggregate over the other entries
+ */
+void combineAggregates(Aggregate *into, Aggregate *from) {
+  into->bytes += from->bytes;
+  if (from->valued == 0) {
+    return;
+  }
+  if (into->valued == 0 || from->min < into->min) {
+    into->min = from->min;
+    into->minCount = from->minCount;
+  } else if (from->min == into->min) {
+    into->minCount += from->minCount;
+  }
+  if (into->valued == 0 || from->max > into->max) {
+    into->max = from->max;
+    into->maxCount = from->maxCount;
+  } else if (from->max == into->max) {
+    into->maxCount += from->maxCount;
+  }
+  into->valued += from->valued;
+  into->sum += from->sum;
+}
+
+/**
+ * Recalculate the aggregate of a node out of its own live entries and the aggregates of its children.
+ * @param node The node, the aggregates of its children are up to date
+ */
+void recalculateAggregate(BTreeNode *node) {
+  emptyAggregate(&node->aggregate);
+  for (int i = 0; i < node->size; i++) {
+    if (node->descriptionValues[i] != NULL) {
+      addEntryToAggregate(&node->aggregate, node->descriptionValues[i]);
+    }
+  }
+  if (!node->leaf) {
+    for (int i = 0; i <= node->size; i++) {
+      combineAggregates(&node->aggregate, &node->childNodes[i]->aggregate);
+    }
+  }
+}
+
+/**
+ * Recalculate the aggregates of a node and all of its parents, e.g. after a split changed the children of node.
+ * @param node The node where we should start (this node will be recalculated too), NULL for none
+ */
+void recalculateAggregatesUp(BTreeNode *node) {
+  for (BTreeNode *cur = node; cur != NULL; cur = cur->parent) {
+    recalculateAggregate(cur);
+  }
+}
+
+/**
+ * Add a new live entry to the aggregates of the node it is in and all of its parents.
+ * @param node The node the entry is in
+ * @param description The description of the entry
+ */
+void aggregateAdded(BTreeNode *node, char *description) {
+  for (BTreeNode *cur = node; cur != NULL; cur = cur->parent) {
+    addEntryToAggregate(&cur->aggregate, description);
+  }
+}
+
+/**
+ * Take an entry that is no longer live out of the aggregates of the node it was in and all of its parents.
+ * @param node The node the entry was in, it is already a gravestone (or gone)
+ * @param description The description of the entry, not freed yet
+ */
+void aggregateRemoved(BTreeNode *node, char *description) {
+  for (BTreeNode *cur = node; cur != NULL; cur = cur->parent) {
+    if (!removeEntryFromAggregate(&cur->aggregate, description)) {
+      recalculateAggregate(cur);
+    }
+  }
+}
+
+/**
+ * Aggregate the live entries of the BTree between begin and end (both inclusive).
+ * @param tree The tree we are aggregating in
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate Set to the aggregate over the entries
+ * @return The amount of entries
+ */
+int aggregateBetweenEntries(BTree *tree, char *begin, char *end, Aggregate *aggregate) {
+  if (tree->shards != NULL) {
+    return shardedAggregateBetweenEntries(tree->shards, begin, end, aggregate);
+  }
+  if (tree->bplus != NULL) {
+    return bplusAggregateBetweenEntries(tree->bplus, begin, end, aggregate);
+  }
+  if (tree->paged != NULL) {
+    return pagedAggregateBetweenEntries(tree->paged, begin, end, aggregate);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridAggregateBetweenEntries(tree->hybrid, begin, end, aggregate);
+  }
+  if (tree->buffered) {
+    // The buffered writes within the range change the aggregate, so they are applied first
+    flushRange(tree, begin, end);
+  }
+
+  int count = 0;
+  emptyAggregate(aggregate);
+  if (tree->root->size > 0) {
+    aggregateBetweenRecursive(tree->root, begin, end, 0, 0, &count, aggregate);
+  }
+  return count;
+}
+
+/**
+ * Recursively aggregate the live entries underneath a node between begin and end (both inclusive). Like
+ * countBetweenRecursive, only the paths to both boundaries are descended, the children in between are added as a
+ * whole.
+ * @param node The current node we are processing
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param fromStart 1 if all entries of the node lie after begin
+ * @param untilEnd 1 if all entries of the node lie before end
+ * @param count The amount of entries, increased
+ * @param aggregate The aggregate, extended
+ */
+void aggregateBetweenRecursive(BTreeNode *node, char *begin, char *end, int fromStart, int untilEnd, int *count,
+                               Aggregate *aggregate) {
+  if (fromStart && untilEnd) {
+    *count += node->recursiveSize;
+    combineAggregates(aggregate, &node->aggregate);
+    return;
+  }
+  int first = fromStart ? 0 : boundIndex(node, begin, 0); // First entry in the range
+  int last = untilEnd ? node->size - 1 : boundIndex(node, end, 1) - 1; // Last entry in the range
+
+  if (first > last) {
+    // No entries of this node are in the range, it is completely inside one child
+    if (!node->leaf) {
+      aggregateBetweenRecursive(node->childNodes[first], begin, end, fromStart, untilEnd, count, aggregate);
+    }
+    return;
+  }
+
+  for (int i = first; i <= last; i++) {
+    if (node->descriptionValues[i] != NULL) {
+      *count += 1;
+      addEntryToAggregate(aggregate, node->descriptionValues[i]);
+    }
+  }
+  if (!node->leaf) {
+    aggregateBetweenRecursive(node->childNodes[first], begin, end, fromStart, 1, count, aggregate);
+    for (int i = first + 1; i <= last; i++) {
+      *count += node->childNodes[i]->recursiveSize;
+      combineAggregates(aggregate, &node->childNodes[i]->aggregate);
+    }
+    aggregateBetweenRecursive(node->childNodes[last + 1], begin, end, 1, untilEnd, count, aggregate);
+  }
+}
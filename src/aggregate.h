@@ -0,0 +1,39 @@
+#ifndef BTREE_AGGREGATE_H
+#define BTREE_AGGREGATE_H
+
+#include "btree.h"
+
+/*
+ * Functions for combining aggregates. A new aggregate needs a field in Aggregate and a line in addEntryToAggregate,
+ * combineAggregates and (if it can't be subtracted) removeEntryFromAggregate.
+ */
+void emptyAggregate(Aggregate *aggregate);
+
+int entryPayload(char *description, double *payload);
+
+void addEntryToAggregate(Aggregate *aggregate, char *description);
+
+int removeEntryFromAggregate(Aggregate *aggregate, char *description);
+
+void combineAggregates(Aggregate *into, Aggregate *from);
+
+/*
+ * Functions for keeping the aggregates of the nodes up to date
+ */
+void recalculateAggregate(BTreeNode *node);
+
+void recalculateAggregatesUp(BTreeNode *node);
+
+void aggregateAdded(BTreeNode *node, char *description);
+
+void aggregateRemoved(BTreeNode *node, char *description);
+
+/*
+ * Functions for aggregating the entries between two keys
+ */
+int aggregateBetweenEntries(BTree *tree, char *begin, char *end, Aggregate *aggregate);
+
+void aggregateBetweenRecursive(BTreeNode *node, char *begin, char *end, int fromStart, int untilEnd, int *count,
+                               Aggregate *aggregate);
+
+#endif //BTREE_AGGREGATE_H
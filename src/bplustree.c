@@ -0,0 +1,752 @@
+#include "bplustree.h"
+#include "aggregate.h"
+
+/**
+ * Create a BTree whose entries are kept in a B+ tree.
+ * @return A created BTree or NULL if we are out of memory
+ */
+BTree *createBPlusBTree() {
+  BTree *tree = (BTree *) malloc(sizeof(BTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->size = 0;
+  tree->root = NULL;
+  tree->shards = NULL;
+  tree->detached.nodes = NULL;
+  tree->detached.size = 0;
+  tree->detached.capacity = 0;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->buffered = 0;
+  tree->filter = NULL;
+  tree->paged = NULL;
+  tree->hybrid = NULL;
+  tree->compaction = NULL;
+  tree->compactBelow = 0;
+  tree->compactCheck = 0;
+  tree->snapshotDirectory = NULL;
+  tree->bplus = createBPlusTree();
+  if (tree->bplus == NULL) {
+    free(tree);
+    return NULL;
+  }
+  return tree;
+}
+
+/**
+ * Create an empty leaf.
+ * @return The created leaf or NULL if we are out of memory
+ */
+static BPlusLeaf *createLeaf() {
+  BPlusLeaf *leaf = malloc(sizeof(BPlusLeaf));
+  if (leaf == NULL) {
+    return NULL;
+  }
+  leaf->node.leaf = 1;
+  leaf->node.size = 0;
+  leaf->previous = NULL;
+  leaf->next = NULL;
+  return leaf;
+}
+
+/**
+ * Create an empty inner node.
+ * @return The created inner node or NULL if we are out of memory
+ */
+static BPlusInner *createInner() {
+  BPlusInner *inner = malloc(sizeof(BPlusInner));
+  if (inner == NULL) {
+    return NULL;
+  }
+  inner->node.leaf = 0;
+  inner->node.size = 0;
+  return inner;
+}
+
+/**
+ * Create an empty B+ tree.
+ * @return The created B+ tree or NULL if we are out of memory
+ */
+BPlusTree *createBPlusTree() {
+  BPlusTree *tree = malloc(sizeof(BPlusTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  BPlusLeaf *root = createLeaf();
+  if (root == NULL) {
+    free(tree);
+    return NULL;
+  }
+  tree->root = &root->node;
+  tree->height = 0;
+  tree->size = 0;
+  return tree;
+}
+
+/**
+ * Free a node, everything underneath it and its entries.
+ * @param node The node we want to free
+ */
+static void freeBPlusNode(BPlusNode *node) {
+  if (node->leaf) {
+    BPlusLeaf *leaf = (BPlusLeaf *) node;
+    for (int i = 0; i < node->size; i++) {
+      free(leaf->descriptionValues[i]);
+    }
+  } else {
+    BPlusInner *inner = (BPlusInner *) node;
+    for (int i = 0; i <= node->size; i++) {
+      freeBPlusNode(inner->children[i]);
+    }
+  }
+  free(node);
+}
+
+/**
+ * Free a B+ tree and all of its entries.
+ * @param tree The B+ tree we want to free
+ */
+void freeBPlusTree(BPlusTree *tree) {
+  freeBPlusNode(tree->root);
+  free(tree);
+}
+
+/**
+ * The amount of keys in a node that are smaller than (or equal to) a key.
+ * @param node The node we are searching in
+ * @param search The key we are searching
+ * @param inclusive 1 to count the keys equal to search as well, 0 otherwise
+ * @return The amount of keys
+ */
+static int rankInNode(BPlusNode *node, char *search, int inclusive) {
+  int low = 0;
+  int high = node->size;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    int cmp = strcmp(node->keys[middle], search);
+    if (cmp < 0 || (inclusive && cmp == 0)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * The amount of entries in and underneath a node.
+ */
+static int nodeCount(BPlusNode *node) {
+  if (node->leaf) {
+    return node->size;
+  }
+  BPlusInner *inner = (BPlusInner *) node;
+  int count = 0;
+  for (int i = 0; i <= node->size; i++) {
+    count += inner->counts[i];
+  }
+  return count;
+}
+
+/**
+ * Calculate the aggregate over the entries in and underneath a node.
+ * @param node The node
+ * @param aggregate Set to the aggregate
+ */
+static void nodeAggregate(BPlusNode *node, Aggregate *aggregate) {
+  emptyAggregate(aggregate);
+  if (node->leaf) {
+    BPlusLeaf *leaf = (BPlusLeaf *) node;
+    for (int i = 0; i < node->size; i++) {
+      addEntryToAggregate(aggregate, leaf->descriptionValues[i]);
+    }
+  } else {
+    BPlusInner *inner = (BPlusInner *) node;
+    for (int i = 0; i <= node->size; i++) {
+      combineAggregates(aggregate, &inner->aggregates[i]);
+    }
+  }
+}
+
+/**
+ * Descend to the leaf where a key belongs, remembering the path.
+ * @param tree The B+ tree we are searching in
+ * @param search The key we are searching, NULL for the first leaf
+ * @param path Filled with the inner nodes on the path, from the root down
+ * @param indexes Filled with the index of the child we took in every inner node of path
+ * @return The leaf
+ */
+static BPlusLeaf *descend(BPlusTree *tree, char *search, BPlusInner **path, int *indexes) {
+  BPlusNode *node = tree->root;
+  for (int level = 0; !node->leaf; level++) {
+    BPlusInner *inner = (BPlusInner *) node;
+    int index = search == NULL ? 0 : rankInNode(node, search, 1);
+    path[level] = inner;
+    indexes[level] = index;
+    node = inner->children[index];
+  }
+  return (BPlusLeaf *) node;
+}
+
+/**
+ * Update the counts on a path after entries were added to or removed from the leaf at its end.
+ */
+static void updateCounts(BPlusTree *tree, BPlusInner **path, int *indexes, int update) {
+  for (int level = 0; level < tree->height; level++) {
+    path[level]->counts[indexes[level]] += update;
+  }
+  tree->size += update;
+}
+
+/**
+ * Add a new entry to the aggregates on the path to its leaf.
+ */
+static void addToAggregates(BPlusTree *tree, BPlusInner **path, int *indexes, char *description) {
+  for (int level = 0; level < tree->height; level++) {
+    addEntryToAggregate(&path[level]->aggregates[indexes[level]], description);
+  }
+}
+
+/**
+ * Take an entry out of the aggregates on the path to the leaf it was in. We go up from the leaf, so an aggregate that
+ * has to be recalculated combines the aggregates below it that are up to date already.
+ * @param tree The B+ tree we are working in
+ * @param path The inner nodes on the path to the leaf
+ * @param indexes The index of the child we took in every inner node of path
+ * @param leaf The leaf, the entry is taken out of it already
+ * @param description The description of the entry, not freed yet
+ */
+static void removeFromAggregates(BPlusTree *tree, BPlusInner **path, int *indexes, BPlusLeaf *leaf,
+                                 char *description) {
+  BPlusNode *child = &leaf->node;
+  for (int level = tree->height - 1; level >= 0; level--) {
+    Aggregate *aggregate = &path[level]->aggregates[indexes[level]];
+    if (!removeEntryFromAggregate(aggregate, description)) {
+      nodeAggregate(child, aggregate);
+    }
+    child = &path[level]->node;
+  }
+}
+
+/**
+ * Recalculate the aggregates on the path to a leaf, after a run of entries was taken out of it.
+ */
+static void recalculateAggregates(BPlusTree *tree, BPlusInner **path, int *indexes, BPlusLeaf *leaf) {
+  BPlusNode *child = &leaf->node;
+  for (int level = tree->height - 1; level >= 0; level--) {
+    nodeAggregate(child, &path[level]->aggregates[indexes[level]]);
+    child = &path[level]->node;
+  }
+}
+
+static void splitInner(BPlusTree *tree, BPlusInner **path, int *indexes, int level);
+
+/**
+ * Add a new right sibling next to a node that was split, in the parent of the node (or in a new root).
+ * @param tree The B+ tree we are working in
+ * @param path The inner nodes on the path to the node
+ * @param indexes The index of the child we took in every inner node of path
+ * @param level The level of the parent in path, -1 if the node is the root
+ * @param left The node that was split
+ * @param separator The smallest key underneath right
+ * @param right The new right sibling
+ */
+static void addChild(BPlusTree *tree, BPlusInner **path, int *indexes, int level, BPlusNode *left, char *separator,
+                     BPlusNode *right) {
+  if (level < 0) {
+    // De root is gesplitst, we moeten een nieuwe root aanmaken
+    BPlusInner *root = createInner();
+    if (root == NULL) {
+      exit(1);
+    }
+    root->node.size = 1;
+    memcpy(root->node.keys[0], separator, DATE);
+    root->children[0] = left;
+    root->children[1] = right;
+    root->counts[0] = nodeCount(left);
+    root->counts[1] = nodeCount(right);
+    nodeAggregate(left, &root->aggregates[0]);
+    nodeAggregate(right, &root->aggregates[1]);
+    tree->root = &root->node;
+    tree->height++;
+    return;
+  }
+
+  BPlusInner *parent = path[level];
+  int index = indexes[level];
+  int size = parent->node.size;
+  memmove(parent->node.keys[index + 1], parent->node.keys[index], DATE * (size - index));
+  memmove(&parent->children[index + 2], &parent->children[index + 1], sizeof(BPlusNode *) * (size - index));
+  memmove(&parent->counts[index + 2], &parent->counts[index + 1], sizeof(int) * (size - index));
+  memmove(&parent->aggregates[index + 2], &parent->aggregates[index + 1], sizeof(Aggregate) * (size - index));
+  memcpy(parent->node.keys[index], separator, DATE);
+  parent->children[index + 1] = right;
+  parent->counts[index] = nodeCount(left);
+  parent->counts[index + 1] = nodeCount(right);
+  nodeAggregate(left, &parent->aggregates[index]);
+  nodeAggregate(right, &parent->aggregates[index + 1]);
+  parent->node.size++;
+
+  if (parent->node.size > BPLUS_FANOUT - 1) {
+    splitInner(tree, path, indexes, level);
+  }
+}
+
+/**
+ * Split an inner node with one key too many, the middle key moves up to the parent.
+ * @param tree The B+ tree we are working in
+ * @param path The inner nodes on the path to the node, the node included
+ * @param indexes The index of the child we took in every inner node of path
+ * @param level The level of the node in path
+ */
+static void splitInner(BPlusTree *tree, BPlusInner **path, int *indexes, int level) {
+  BPlusInner *node = path[level];
+  BPlusInner *right = createInner();
+  if (right == NULL) {
+    exit(1);
+  }
+
+  int keep = node->node.size / 2;
+  int moved = node->node.size - keep - 1;
+  char separator[DATE];
+  memcpy(separator, node->node.keys[keep], DATE);
+  memcpy(right->node.keys, node->node.keys[keep + 1], DATE * moved);
+  memcpy(right->children, &node->children[keep + 1], sizeof(BPlusNode *) * (moved + 1));
+  memcpy(right->counts, &node->counts[keep + 1], sizeof(int) * (moved + 1));
+  memcpy(right->aggregates, &node->aggregates[keep + 1], sizeof(Aggregate) * (moved + 1));
+  right->node.size = moved;
+  node->node.size = keep;
+
+  addChild(tree, path, indexes, level - 1, &node->node, separator, &right->node);
+}
+
+/**
+ * Split a leaf with one entry too many, the upper half moves to a new leaf right of it.
+ * @param tree The B+ tree we are working in
+ * @param path The inner nodes on the path to the leaf
+ * @param indexes The index of the child we took in every inner node of path
+ * @param leaf The leaf we are splitting
+ */
+static void splitLeaf(BPlusTree *tree, BPlusInner **path, int *indexes, BPlusLeaf *leaf) {
+  BPlusLeaf *right = createLeaf();
+  if (right == NULL) {
+    exit(1);
+  }
+
+  int keep = (leaf->node.size + 1) / 2;
+  int moved = leaf->node.size - keep;
+  memcpy(right->node.keys, leaf->node.keys[keep], DATE * moved);
+  memcpy(right->descriptionValues, &leaf->descriptionValues[keep], sizeof(char *) * moved);
+  right->node.size = moved;
+  leaf->node.size = keep;
+
+  right->previous = leaf;
+  right->next = leaf->next;
+  if (right->next != NULL) {
+    right->next->previous = right;
+  }
+  leaf->next = right;
+
+  addChild(tree, path, indexes, tree->height - 1, &leaf->node, right->node.keys[0], &right->node);
+}
+
+/**
+ * Insert an entry. The B+ tree keeps its own copy of the key, so date is freed. Like overwriteEntry, an entry that is
+ * already in the tree keeps its description.
+ * @param tree The B+ tree where we want to add an entry
+ * @param date The date we want to add
+ * @param description A description of the date
+ */
+void bplusInsertEntry(BPlusTree *tree, char *date, char *description) {
+  BPlusInner *path[BPLUS_MAX_HEIGHT];
+  int indexes[BPLUS_MAX_HEIGHT];
+  BPlusLeaf *leaf = descend(tree, date, path, indexes);
+
+  int index = rankInNode(&leaf->node, date, 0);
+  if (index < leaf->node.size && strcmp(leaf->node.keys[index], date) == 0) {
+    free(date);
+    free(description);
+    return;
+  }
+
+  int size = leaf->node.size;
+  memmove(leaf->node.keys[index + 1], leaf->node.keys[index], DATE * (size - index));
+  memmove(&leaf->descriptionValues[index + 1], &leaf->descriptionValues[index], sizeof(char *) * (size - index));
+  strncpy(leaf->node.keys[index], date, DATE - 1);
+  leaf->node.keys[index][DATE - 1] = '\0';
+  leaf->descriptionValues[index] = description;
+  leaf->node.size++;
+  free(date);
+
+  updateCounts(tree, path, indexes, +1);
+  addToAggregates(tree, path, indexes, description);
+  if (leaf->node.size > BPLUS_LEAF) {
+    splitLeaf(tree, path, indexes, leaf);
+  }
+}
+
+/**
+ * Find the description of an entry.
+ * @param tree The B+ tree we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description or NULL if date is not found
+ */
+char *bplusGetEntry(BPlusTree *tree, char *date) {
+  BPlusNode *node = tree->root;
+  while (!node->leaf) {
+    node = ((BPlusInner *) node)->children[rankInNode(node, date, 1)];
+  }
+  int index = rankInNode(node, date, 0);
+  if (index < node->size && strcmp(node->keys[index], date) == 0) {
+    return ((BPlusLeaf *) node)->descriptionValues[index];
+  }
+  return NULL;
+}
+
+/**
+ * Check if a node has less keys than a node that is not the root should have.
+ */
+static int underfull(BPlusNode *node) {
+  return node->leaf ? node->size < BPLUS_LEAF / 2 : node->size < (BPLUS_FANOUT + 1) / 2 - 1;
+}
+
+/**
+ * Merge two neighbouring children of an inner node, the right one is freed.
+ * @param parent The inner node
+ * @param first The index of the left child
+ */
+static void mergeChildren(BPlusInner *parent, int first) {
+  BPlusNode *left = parent->children[first];
+  BPlusNode *right = parent->children[first + 1];
+
+  if (left->leaf) {
+    BPlusLeaf *leftLeaf = (BPlusLeaf *) left;
+    BPlusLeaf *rightLeaf = (BPlusLeaf *) right;
+    memcpy(left->keys[left->size], right->keys, DATE * right->size);
+    memcpy(&leftLeaf->descriptionValues[left->size], rightLeaf->descriptionValues, sizeof(char *) * right->size);
+    left->size += right->size;
+    leftLeaf->next = rightLeaf->next;
+    if (leftLeaf->next != NULL) {
+      leftLeaf->next->previous = leftLeaf;
+    }
+  } else {
+    BPlusInner *leftInner = (BPlusInner *) left;
+    BPlusInner *rightInner = (BPlusInner *) right;
+    // The separator comes down between the keys of both nodes
+    memcpy(left->keys[left->size], parent->node.keys[first], DATE);
+    memcpy(left->keys[left->size + 1], right->keys, DATE * right->size);
+    memcpy(&leftInner->children[left->size + 1], rightInner->children, sizeof(BPlusNode *) * (right->size + 1));
+    memcpy(&leftInner->counts[left->size + 1], rightInner->counts, sizeof(int) * (right->size + 1));
+    memcpy(&leftInner->aggregates[left->size + 1], rightInner->aggregates, sizeof(Aggregate) * (right->size + 1));
+    left->size += right->size + 1;
+  }
+  free(right);
+
+  int size = parent->node.size;
+  parent->counts[first] += parent->counts[first + 1];
+  combineAggregates(&parent->aggregates[first], &parent->aggregates[first + 1]);
+  memmove(parent->node.keys[first], parent->node.keys[first + 1], DATE * (size - first - 1));
+  memmove(&parent->children[first + 1], &parent->children[first + 2], sizeof(BPlusNode *) * (size - first - 1));
+  memmove(&parent->counts[first + 1], &parent->counts[first + 2], sizeof(int) * (size - first - 1));
+  memmove(&parent->aggregates[first + 1], &parent->aggregates[first + 2], sizeof(Aggregate) * (size - first - 1));
+  parent->node.size--;
+}
+
+/**
+ * Even out the keys of two neighbouring children of an inner node.
+ * @param parent The inner node
+ * @param first The index of the left child
+ */
+static void redistributeChildren(BPlusInner *parent, int first) {
+  BPlusNode *left = parent->children[first];
+  BPlusNode *right = parent->children[first + 1];
+
+  if (left->leaf) {
+    BPlusLeaf *leftLeaf = (BPlusLeaf *) left;
+    BPlusLeaf *rightLeaf = (BPlusLeaf *) right;
+    int total = left->size + right->size;
+    int keep = total / 2;
+    if (left->size > keep) {
+      // Move the last entries of left to the front of right
+      int moved = left->size - keep;
+      memmove(right->keys[moved], right->keys, DATE * right->size);
+      memmove(&rightLeaf->descriptionValues[moved], rightLeaf->descriptionValues, sizeof(char *) * right->size);
+      memcpy(right->keys, left->keys[keep], DATE * moved);
+      memcpy(rightLeaf->descriptionValues, &leftLeaf->descriptionValues[keep], sizeof(char *) * moved);
+    } else {
+      // Move the first entries of right to the end of left
+      int moved = keep - left->size;
+      memcpy(left->keys[left->size], right->keys, DATE * moved);
+      memcpy(&leftLeaf->descriptionValues[left->size], rightLeaf->descriptionValues, sizeof(char *) * moved);
+      memmove(right->keys, right->keys[moved], DATE * (right->size - moved));
+      memmove(rightLeaf->descriptionValues, &rightLeaf->descriptionValues[moved],
+              sizeof(char *) * (right->size - moved));
+    }
+    left->size = keep;
+    right->size = total - keep;
+    memcpy(parent->node.keys[first], right->keys[0], DATE);
+  } else {
+    // Rotate one child at a time through the separator in the parent
+    BPlusInner *leftInner = (BPlusInner *) left;
+    BPlusInner *rightInner = (BPlusInner *) right;
+    while (left->size + 1 < right->size) {
+      memcpy(left->keys[left->size], parent->node.keys[first], DATE);
+      leftInner->children[left->size + 1] = rightInner->children[0];
+      leftInner->counts[left->size + 1] = rightInner->counts[0];
+      leftInner->aggregates[left->size + 1] = rightInner->aggregates[0];
+      left->size++;
+      memcpy(parent->node.keys[first], right->keys[0], DATE);
+      memmove(right->keys, right->keys[1], DATE * (right->size - 1));
+      memmove(rightInner->children, &rightInner->children[1], sizeof(BPlusNode *) * right->size);
+      memmove(rightInner->counts, &rightInner->counts[1], sizeof(int) * right->size);
+      memmove(rightInner->aggregates, &rightInner->aggregates[1], sizeof(Aggregate) * right->size);
+      right->size--;
+    }
+    while (right->size + 1 < left->size) {
+      memmove(right->keys[1], right->keys, DATE * right->size);
+      memmove(&rightInner->children[1], rightInner->children, sizeof(BPlusNode *) * (right->size + 1));
+      memmove(&rightInner->counts[1], rightInner->counts, sizeof(int) * (right->size + 1));
+      memmove(&rightInner->aggregates[1], rightInner->aggregates, sizeof(Aggregate) * (right->size + 1));
+      memcpy(right->keys[0], parent->node.keys[first], DATE);
+      rightInner->children[0] = leftInner->children[left->size];
+      rightInner->counts[0] = leftInner->counts[left->size];
+      rightInner->aggregates[0] = leftInner->aggregates[left->size];
+      right->size++;
+      memcpy(parent->node.keys[first], left->keys[left->size - 1], DATE);
+      left->size--;
+    }
+  }
+  parent->counts[first] = nodeCount(left);
+  parent->counts[first + 1] = nodeCount(right);
+  nodeAggregate(left, &parent->aggregates[first]);
+  nodeAggregate(right, &parent->aggregates[first + 1]);
+}
+
+/**
+ * Repair the nodes on a path after entries were removed from the leaf at its end. An underfull node is merged with a
+ * sibling if they fit in one node, otherwise the keys of both are evened out.
+ * @param tree The B+ tree we are working in
+ * @param path The inner nodes on the path to the leaf
+ * @param indexes The index of the child we took in every inner node of path
+ * @param leaf The leaf that lost entries
+ */
+static void rebalance(BPlusTree *tree, BPlusInner **path, int *indexes, BPlusLeaf *leaf) {
+  BPlusNode *node = &leaf->node;
+  for (int level = tree->height - 1; level >= 0 && underfull(node); level--) {
+    BPlusInner *parent = path[level];
+    int first = indexes[level] > 0 ? indexes[level] - 1 : 0;
+    BPlusNode *left = parent->children[first];
+    BPlusNode *right = parent->children[first + 1];
+
+    int fits = left->leaf ? left->size + right->size <= BPLUS_LEAF : left->size + right->size + 1 <= BPLUS_FANOUT - 1;
+    if (fits) {
+      mergeChildren(parent, first);
+    } else {
+      redistributeChildren(parent, first);
+    }
+    node = &parent->node;
+  }
+
+  while (!tree->root->leaf && tree->root->size == 0) {
+    // De root heeft nog maar een kind, dat wordt de nieuwe root
+    BPlusInner *root = (BPlusInner *) tree->root;
+    tree->root = root->children[0];
+    tree->height--;
+    free(root);
+  }
+}
+
+/**
+ * Remove an entry.
+ * @param tree The B+ tree where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not in the tree), 1 if succeeded
+ */
+int bplusRemoveEntry(BPlusTree *tree, char *date) {
+  BPlusInner *path[BPLUS_MAX_HEIGHT];
+  int indexes[BPLUS_MAX_HEIGHT];
+  BPlusLeaf *leaf = descend(tree, date, path, indexes);
+
+  int index = rankInNode(&leaf->node, date, 0);
+  if (index == leaf->node.size || strcmp(leaf->node.keys[index], date) != 0) {
+    return 0;
+  }
+
+  char *description = leaf->descriptionValues[index];
+  int size = leaf->node.size;
+  memmove(leaf->node.keys[index], leaf->node.keys[index + 1], DATE * (size - index - 1));
+  memmove(&leaf->descriptionValues[index], &leaf->descriptionValues[index + 1], sizeof(char *) * (size - index - 1));
+  leaf->node.size--;
+
+  updateCounts(tree, path, indexes, -1);
+  removeFromAggregates(tree, path, indexes, leaf, description);
+  free(description);
+  rebalance(tree, path, indexes, leaf);
+  return 1;
+}
+
+/**
+ * The amount of entries smaller than (or equal to) a key, summed from the counts on the path to its leaf.
+ * @param tree The B+ tree we are counting in
+ * @param search The key
+ * @param inclusive 1 to count an entry on search as well, 0 otherwise
+ * @return The amount of entries
+ */
+static int rank(BPlusTree *tree, char *search, int inclusive) {
+  BPlusNode *node = tree->root;
+  int count = 0;
+  while (!node->leaf) {
+    BPlusInner *inner = (BPlusInner *) node;
+    int index = rankInNode(node, search, 1);
+    for (int i = 0; i < index; i++) {
+      count += inner->counts[i];
+    }
+    node = inner->children[index];
+  }
+  return count + rankInNode(node, search, inclusive);
+}
+
+/**
+ * Count the entries between begin and end (both inclusive).
+ * @param tree The B+ tree where we will be counting
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The count of entries between begin and end
+ */
+int bplusCountBetweenEntries(BPlusTree *tree, char *begin, char *end) {
+  int count = rank(tree, end, 1) - rank(tree, begin, 0);
+  return count > 0 ? count : 0;
+}
+
+/**
+ * Aggregate the entries underneath a node between begin and end (both inclusive). Like aggregateBetweenRecursive,
+ * only the paths to both boundaries are descended, the children in between add the aggregates their parent keeps.
+ * @param node The current node we are processing
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param fromStart 1 if all entries of the node lie after begin
+ * @param untilEnd 1 if all entries of the node lie before end
+ * @param count The amount of entries, increased
+ * @param aggregate The aggregate, extended
+ */
+static void aggregateRange(BPlusNode *node, char *begin, char *end, int fromStart, int untilEnd, int *count,
+                           Aggregate *aggregate) {
+  if (node->leaf) {
+    BPlusLeaf *leaf = (BPlusLeaf *) node;
+    int last = untilEnd ? node->size : rankInNode(node, end, 1);
+    for (int i = fromStart ? 0 : rankInNode(node, begin, 0); i < last; i++) {
+      addEntryToAggregate(aggregate, leaf->descriptionValues[i]);
+      *count += 1;
+    }
+    return;
+  }
+
+  BPlusInner *inner = (BPlusInner *) node;
+  int first = fromStart ? 0 : rankInNode(node, begin, 1); // The child begin is in
+  int last = untilEnd ? node->size : rankInNode(node, end, 1); // The child end is in
+  if (first >= last) {
+    if (first == last) {
+      aggregateRange(inner->children[first], begin, end, fromStart, untilEnd, count, aggregate);
+    }
+    return;
+  }
+  aggregateRange(inner->children[first], begin, end, fromStart, 1, count, aggregate);
+  for (int i = first + 1; i < last; i++) {
+    *count += inner->counts[i];
+    combineAggregates(aggregate, &inner->aggregates[i]);
+  }
+  aggregateRange(inner->children[last], begin, end, 1, untilEnd, count, aggregate);
+}
+
+/**
+ * Aggregate the entries between begin and end (both inclusive), out of the aggregates the inner nodes keep for their
+ * children.
+ * @param tree The B+ tree where we will be aggregating
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate Set to the aggregate over the entries
+ * @return The amount of entries
+ */
+int bplusAggregateBetweenEntries(BPlusTree *tree, char *begin, char *end, Aggregate *aggregate) {
+  int count = 0;
+  emptyAggregate(aggregate);
+  aggregateRange(tree->root, begin, end, 0, 0, &count, aggregate);
+  return count;
+}
+
+/**
+ * Remove all entries from start up to end. We walk the leafs from start on and take out all entries of the range in
+ * a leaf at once, then repair the path to that leaf.
+ * @param tree The B+ tree where we want to remove entries
+ * @param start The begin boundary (inclusive), NULL to remove from the first entry on
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if an entry on end should be removed as well, 0 otherwise
+ * @return The amount of entries that were removed
+ */
+int bplusRemoveRange(BPlusTree *tree, char *start, char *end, int inclusiveEnd) {
+  BPlusInner *path[BPLUS_MAX_HEIGHT];
+  int indexes[BPLUS_MAX_HEIGHT];
+  char cursor[DATE];
+  char *from = start;
+  int removed = 0;
+
+  while (1) {
+    BPlusLeaf *leaf = descend(tree, from, path, indexes);
+    int first = from == NULL ? 0 : rankInNode(&leaf->node, from, 0);
+    if (first == leaf->node.size) {
+      // Everything in this leaf lies before the range, go on with the next leaf
+      if (leaf->next == NULL) break;
+      memcpy(cursor, leaf->next->node.keys[0], DATE);
+      from = cursor;
+      continue;
+    }
+
+    int last = first;
+    while (last < leaf->node.size) {
+      int cmp = strcmp(leaf->node.keys[last], end);
+      if (cmp > 0 || (cmp == 0 && !inclusiveEnd)) break;
+      free(leaf->descriptionValues[last]);
+      last++;
+    }
+    if (last == first) break;
+
+    int amount = last - first;
+    memmove(leaf->node.keys[first], leaf->node.keys[last], DATE * (leaf->node.size - last));
+    memmove(&leaf->descriptionValues[first], &leaf->descriptionValues[last],
+            sizeof(char *) * (leaf->node.size - last));
+    leaf->node.size -= amount;
+    removed += amount;
+
+    updateCounts(tree, path, indexes, -amount);
+    recalculateAggregates(tree, path, indexes, leaf);
+    rebalance(tree, path, indexes, leaf);
+  }
+  return removed;
+}
+
+/**
+ * Visit the first or last entries, along the links between the leafs.
+ * @param tree The B+ tree we are working in
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int bplusEdgeEntries(BPlusTree *tree, int last, int count, EntryVisitor visit, void *context) {
+  BPlusNode *node = tree->root;
+  while (!node->leaf) {
+    node = ((BPlusInner *) node)->children[last ? node->size : 0];
+  }
+
+  int visited = 0;
+  BPlusLeaf *leaf = (BPlusLeaf *) node;
+  for (; leaf != NULL && visited < count; leaf = last ? leaf->previous : leaf->next) {
+    for (int step = 0; step < leaf->node.size && visited < count; step++) {
+      int index = last ? leaf->node.size - 1 - step : step;
+      visited += visit(leaf->node.keys[index], leaf->descriptionValues[index], context);
+    }
+  }
+  return visited;
+}
@@ -0,0 +1,82 @@
+#ifndef BTREE_BPLUSTREE_H
+#define BTREE_BPLUSTREE_H
+
+#include "btree.h"
+
+#ifndef BPLUS_FANOUT
+#define BPLUS_FANOUT 64 // maximum amount of children of an inner node, at least 4
+#endif
+#ifndef BPLUS_LEAF
+#define BPLUS_LEAF 64 // maximum amount of entries in a leaf, at least 2
+#endif
+#define BPLUS_MAX_HEIGHT 32 // the tree can't get higher than this, every level at least halves the entries
+
+typedef struct BPlusNode BPlusNode;
+typedef struct BPlusLeaf BPlusLeaf;
+
+/**
+ * Struct representing the part that inner nodes and leafs of a B+ tree have in common, it is the start of both
+ */
+struct BPlusNode {
+    int leaf; // leaf: 1, inner node: 0
+    int size; // leaf: amount of entries, inner node: amount of separator keys (one less than its children)
+    char keys[BPLUS_FANOUT > BPLUS_LEAF + 1 ? BPLUS_FANOUT : BPLUS_LEAF + 1][DATE]; // The keys, one spare for splits
+};
+
+/**
+ * Struct representing an inner node of a B+ tree, it only routes. Separator keys[i] is the smallest key in
+ * children[i + 1].
+ */
+typedef struct BPlusInner {
+    BPlusNode node; // The keys and size of the node
+    BPlusNode *children[BPLUS_FANOUT + 1]; // The children of the node, one spare for splits
+    int counts[BPLUS_FANOUT + 1]; // The amount of entries underneath every child
+    Aggregate aggregates[BPLUS_FANOUT + 1]; // The aggregates over the entries underneath every child
+} BPlusInner;
+
+/**
+ * Struct representing a leaf of a B+ tree, it holds the entries and is linked to its siblings
+ */
+struct BPlusLeaf {
+    BPlusNode node; // The keys and size of the leaf
+    char *descriptionValues[BPLUS_LEAF + 1]; // The descriptions of the entries, one spare for splits
+    BPlusLeaf *previous; // The leaf to the left, NULL for the first leaf
+    BPlusLeaf *next; // The leaf to the right, NULL for the last leaf
+};
+
+/**
+ * Struct representing a B+ tree, the engine behind a BTree created by createBPlusBTree
+ */
+struct BPlusTree {
+    BPlusNode *root; // The root, a leaf as long as the tree is small
+    int height; // The amount of inner levels above the leafs
+    int size; // The amount of entries in the tree
+};
+
+/*
+ * Functions for the creation and free-ing of B+ trees
+ */
+BTree *createBPlusBTree();
+
+BPlusTree *createBPlusTree();
+
+void freeBPlusTree(BPlusTree *tree);
+
+/*
+ * Functions behind the BTree API for B+ trees
+ */
+void bplusInsertEntry(BPlusTree *tree, char *date, char *description);
+
+char *bplusGetEntry(BPlusTree *tree, char *date);
+
+int bplusRemoveEntry(BPlusTree *tree, char *date);
+
+int bplusCountBetweenEntries(BPlusTree *tree, char *begin, char *end);
+
+int bplusAggregateBetweenEntries(BPlusTree *tree, char *begin, char *end, Aggregate *aggregate);
+
+int bplusRemoveRange(BPlusTree *tree, char *start, char *end, int inclusiveEnd);
+
+int bplusEdgeEntries(BPlusTree *tree, int last, int count, EntryVisitor visit, void *context);
+
+#endif //BTREE_BPLUSTREE_H
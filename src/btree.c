@@ -1,5 +1,13 @@
 #include "./btree.h"
 #include "./util.h"
+#include "./shard.h"
+#include "./buffer.h"
+#include "./filter.h"
+#include "./bplustree.h"
+#include "./pagedtree.h"
+#include "./hybrid.h"
+#include "./compact.h"
+#include "./aggregate.h"
 
 
 /**
@@ -21,6 +29,60 @@ BTreeNode *searchNode(BTreeNode *node, char *search, int add, int recursive) {
  * @param description A description of the date
  */
 void insertEntry(BTree *tree, char *date, char *description) {
+  if (tree->shards != NULL) {
+    shardedInsertEntry(tree->shards, date, description);
+    return;
+  }
+  if (tree->bplus != NULL) {
+    bplusInsertEntry(tree->bplus, date, description);
+    return;
+  }
+  if (tree->paged != NULL) {
+    pagedInsertEntry(tree->paged, date, description);
+    return;
+  }
+  if (tree->hybrid != NULL) {
+    hybridInsertEntry(tree->hybrid, date, description);
+    return;
+  }
+  if (tree->compaction != NULL) {
+    logCompactedWrite(tree, '+', date, description, NULL, 0);
+  }
+  if (tree->filter == NULL) {
+    if (tree->buffered && !tree->root->leaf) {
+      bufferMessage(tree, date, description);
+    } else {
+      insertEntryUnbuffered(tree, date, description);
+    }
+    return;
+  }
+
+  // The date might be freed by the insert, hash it first
+  uint64_t hash = hashKey(date);
+  if (tree->buffered && !tree->root->leaf) {
+    // Look the key up through the pending messages, like a removal does, so a live key doesn't get a second copy
+    int live = filterContains(tree->filter, hash) && bufferedGetEntry(tree, date) != NULL;
+    bufferMessage(tree, date, description);
+    if (!live) {
+      filterInserted(tree, hash);
+    }
+  } else {
+    int live = tree->root->recursiveSize;
+    insertEntryUnbuffered(tree, date, description);
+    if (tree->root->recursiveSize != live) {
+      // A new entry or a gravestone that came back to life
+      filterInserted(tree, hash);
+    }
+  }
+}
+
+/**
+ * Insert or overwrite an entry in the BTree, straight in its leaf (or the node it is in).
+ * @param tree The tree where we want to add an entry
+ * @param date The date we want to add
+ * @param description A description of the date
+ */
+void insertEntryUnbuffered(BTree *tree, char *date, char *description) {
   BTreeNode *node = searchNode(tree->root, date, 1, 1);
 
   if (searchNode(node, date, 0, 0) != NULL) {
@@ -49,6 +111,7 @@ void overwriteEntry(BTreeNode *node, char *date, char *description) {
       // If we re-add it it isn't removed anymore so we should change gravestone, and recursively update sizes!
       node->descriptionValues[index] = description;
       updateRecursiveSizes(node, +1);
+      aggregateAdded(node, description);
     }
   } // else: should not be able to happen
 }
@@ -114,22 +177,36 @@ void addEntryToTop(BTree *tree, BTreeNode *node, char *date, char *description,
   node->descriptionValues[index] = description;
   node->size++;
 
-  if (!leafs) {
-    addChildNodes(node, index, lChildAdd, rChildAdd);
+  if (leafs) {
+    // Only the new entry changes the sizes and aggregates of the leaf and all above it
+    updateRecursiveSizes(node, +1);
+    updateRecursiveCounts(node, +1, 0);
+    aggregateAdded(node, description);
+    return;
   }
+  addChildNodes(node, index, lChildAdd, rChildAdd);
   // All above can be +1-ed
   updateRecursiveSizes(node->parent, +1);
   // This node and all nodes underneath should be recalculated
+  int nodes = node->recursiveNodes;
   node->recursiveSize = -1;
   recalculateRecursiveSizes(node);
+  // The splits underneath added nodes, the nodes above get them as well
+  updateRecursiveCounts(node->parent, +1, node->recursiveNodes - nodes);
+  // The new entry is somewhere underneath the split child, the aggregates above are recalculated (once per split)
+  recalculateAggregatesUp(node->parent);
 }
 
 /**
- * Recalculate the recursiveSize fields of all the nodes below a node.
+ * Recalculate the recursiveSize (and recursiveEntries, recursiveNodes, pendingMessages and aggregate) fields of all
+ * the nodes below a node.
  * @param node The node wherefrom we should start
  */
 void recalculateRecursiveSizes(BTreeNode *node) {
   node->recursiveSize = 0;
+  node->recursiveEntries = node->size;
+  node->recursiveNodes = 1;
+  node->pendingMessages = node->messageCount;
   for (int i = 0; i < node->size; i++) {
     if (node->descriptionValues[i] != NULL) node->recursiveSize += 1;
   }
@@ -139,8 +216,12 @@ void recalculateRecursiveSizes(BTreeNode *node) {
         recalculateRecursiveSizes(node->childNodes[i]);
       }
       node->recursiveSize += node->childNodes[i]->recursiveSize;
+      node->recursiveEntries += node->childNodes[i]->recursiveEntries;
+      node->recursiveNodes += node->childNodes[i]->recursiveNodes;
+      node->pendingMessages += node->childNodes[i]->pendingMessages;
     }
   }
+  recalculateAggregate(node);
 }
 
 /**
@@ -266,6 +347,13 @@ void rebalanceRecursive(BTree *tree, BTreeNode *node, char *date, char *descript
   rChild->recursiveSize = -1;
   addAndRebalanceRecursive(tree, node->parent, newParentDate, newParentDescription, lChild,
                            rChild, 0);
+  // The halves take the place of the node at the edges
+  if (tree->firstLeaf == node) {
+    tree->firstLeaf = lChild;
+  }
+  if (tree->lastLeaf == node) {
+    tree->lastLeaf = rChild;
+  }
   freeNode(node);
 }
 
@@ -280,6 +368,21 @@ BTree *createBTree() {
     return NULL;
   }
   tree->size = 0;
+  tree->shards = NULL;
+  tree->detached.nodes = NULL;
+  tree->detached.size = 0;
+  tree->detached.capacity = 0;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->buffered = 0;
+  tree->filter = NULL;
+  tree->bplus = NULL;
+  tree->paged = NULL;
+  tree->hybrid = NULL;
+  tree->compaction = NULL;
+  tree->compactBelow = 0;
+  tree->compactCheck = 0;
+  tree->snapshotDirectory = NULL;
   tree->root = createBTreeNode(1);
   if (tree->root == NULL) {
     free(tree);
@@ -308,6 +411,15 @@ BTreeNode *createBTreeNode(int leaf) {
 
   node->size = 0;
   node->recursiveSize = 0;
+  node->recursiveEntries = 0;
+  node->recursiveNodes = 1;
+  emptyAggregate(&node->aggregate);
+
+  node->messages = NULL;
+  node->messageCount = 0;
+  node->messageCapacity = 0;
+  node->pendingMessages = 0;
+  node->arena = NULL;
 
   node->leaf = leaf;
   return node;
@@ -339,6 +451,25 @@ void printTree(BTreeNode *node, int depth) {
  * @return The entry description or NULL if date is not found
  */
 char *getEntry(BTree *tree, char *date) {
+  if (tree->shards != NULL) {
+    return shardedGetEntry(tree->shards, date);
+  }
+  if (tree->bplus != NULL) {
+    return bplusGetEntry(tree->bplus, date);
+  }
+  if (tree->paged != NULL) {
+    return pagedGetEntry(tree->paged, date);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridGetEntry(tree->hybrid, date);
+  }
+  if (tree->filter != NULL && !filterContains(tree->filter, hashKey(date))) {
+    return NULL;
+  }
+  if (tree->buffered) {
+    return bufferedGetEntry(tree, date);
+  }
+
   BTreeNode *node = searchNode(tree->root, date, 0, 1);
   if (node == NULL) return NULL;
 
@@ -356,6 +487,43 @@ char *getEntry(BTree *tree, char *date) {
  * @return 0 if failed (date was not in Tree), 1 if succeeded
  */
 int removeEntry(BTree *tree, char *date) {
+  if (tree->shards != NULL) {
+    return shardedRemoveEntry(tree->shards, date);
+  }
+  if (tree->bplus != NULL) {
+    return bplusRemoveEntry(tree->bplus, date);
+  }
+  if (tree->paged != NULL) {
+    return pagedRemoveEntry(tree->paged, date);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridRemoveEntry(tree->hybrid, date);
+  }
+  if (tree->compaction != NULL) {
+    logCompactedWrite(tree, '-', date, NULL, NULL, 0);
+  }
+  if (tree->filter == NULL) {
+    return tree->buffered ? bufferedRemoveEntry(tree, date) : removeEntryUnbuffered(tree, date);
+  }
+
+  uint64_t hash = hashKey(date);
+  if (!filterContains(tree->filter, hash)) {
+    return 0;
+  }
+  int status = tree->buffered ? bufferedRemoveEntry(tree, date) : removeEntryUnbuffered(tree, date);
+  if (status) {
+    filterRemove(tree->filter, hash);
+  }
+  return status;
+}
+
+/**
+ * Remove an entry of the tree, straight from its leaf (or the node it is in).
+ * @param tree The Tree where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not in Tree), 1 if succeeded
+ */
+int removeEntryUnbuffered(BTree *tree, char *date) {
   BTreeNode *node = searchNode(tree->root, date, 0, 1);
   if (node == NULL) {
     return 0;
@@ -365,14 +533,350 @@ int removeEntry(BTree *tree, char *date) {
 
   if (index >= 0 && node->descriptionValues[index] != NULL) {
     // We found the node and it didn't have a gravestone yet.
-    free(node->descriptionValues[index]);
+    char *description = node->descriptionValues[index];
     node->descriptionValues[index] = NULL;
     updateRecursiveSizes(node, -1);
+    aggregateRemoved(node, description);
+    free(description);
     return 1;
   }
   return 0;
 }
 
+/**
+ * Remove all entries between start and end (both inclusive) from the tree. Subtrees that lie completely within the
+ * range are cut out as a whole and freed later on by reclaimDetached, only the nodes on the paths to start and end
+ * are changed.
+ * @param tree The tree where we want to remove entries
+ * @param start The begin boundary
+ * @param end The end boundary
+ * @return The amount of (non-removed) entries that were removed
+ */
+int removeRange(BTree *tree, char *start, char *end) {
+  return removeRangeBetween(tree, start, end, 1);
+}
+
+/**
+ * Remove all entries older than a cutoff from the tree, e.g. for a retention policy.
+ * @param tree The tree where we want to remove entries
+ * @param cutoff The oldest date that is kept
+ * @return The amount of (non-removed) entries that were removed
+ */
+int expireBefore(BTree *tree, char *cutoff) {
+  return removeRangeBetween(tree, NULL, cutoff, 0);
+}
+
+/**
+ * Remove all entries between start and end from the tree.
+ * @param tree The tree where we want to remove entries
+ * @param start The begin boundary (inclusive), NULL to start at the first entry
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if end itself should be removed too, 0 otherwise
+ * @return The amount of (non-removed) entries that were removed
+ */
+int removeRangeBetween(BTree *tree, char *start, char *end, int inclusiveEnd) {
+  if (tree->shards != NULL) {
+    return shardedRemoveRange(tree->shards, start, end, inclusiveEnd);
+  }
+  if (tree->bplus != NULL) {
+    return bplusRemoveRange(tree->bplus, start, end, inclusiveEnd);
+  }
+  if (tree->paged != NULL) {
+    return pagedRemoveRange(tree->paged, start, end, inclusiveEnd);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridRemoveRange(tree->hybrid, start, end, inclusiveEnd);
+  }
+  if (tree->compaction != NULL) {
+    logCompactedWrite(tree, '/', start, NULL, end, inclusiveEnd);
+  }
+  if (tree->root->size == 0) {
+    return 0;
+  }
+  if (tree->buffered) {
+    // The nodes are restructured, so all buffered writes have to be in place first
+    flushRange(tree, NULL, NULL);
+  }
+
+  int before = tree->root->recursiveSize;
+  removeRangeRecursive(tree, tree->root, start, end, inclusiveEnd);
+
+  while (!tree->root->leaf && tree->root->size == 0) {
+    // The root lost all of its entries, its only child becomes the new root
+    BTreeNode *oldRoot = tree->root;
+    tree->root = oldRoot->childNodes[0];
+    tree->root->parent = NULL;
+    releaseNode(oldRoot);
+  }
+  // Leafs at the edges may have been merged or detached
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  recalculateRecursiveSizes(tree->root);
+  if (tree->filter != NULL) {
+    // The removed keys keep their fingerprint, until there are too many of them
+    syncFilter(tree);
+  }
+  return before - tree->root->recursiveSize;
+}
+
+/**
+ * Merge a child that lost all of its entries with one of its siblings, using the entry between them as separator.
+ * Nothing happens if the child still has entries or if the parent has no entries itself, then the parent has to
+ * be repaired first.
+ * @param tree The tree we are working in
+ * @param parent The parent of the child
+ * @param index The index of the child in the parent
+ */
+static void repairChild(BTree *tree, BTreeNode *parent, int index) {
+  BTreeNode *child = parent->childNodes[index];
+  if (child->size > 0 || parent->size == 0) {
+    return;
+  }
+
+  char *keys[N + 1];
+  char *descriptions[N + 1];
+  BTreeNode *children[N + 2];
+
+  int separator = index > 0 ? index - 1 : index;
+  BTreeNode *left = parent->childNodes[separator];
+  BTreeNode *right = parent->childNodes[separator + 1];
+
+  int total = 0;
+  int childTotal = 0;
+  for (int i = 0; i < left->size; i++, total++) {
+    keys[total] = left->dateKeys[i];
+    descriptions[total] = left->descriptionValues[i];
+  }
+  keys[total] = parent->dateKeys[separator];
+  descriptions[total] = parent->descriptionValues[separator];
+  total++;
+  for (int i = 0; i < right->size; i++, total++) {
+    keys[total] = right->dateKeys[i];
+    descriptions[total] = right->descriptionValues[i];
+  }
+  if (!left->leaf) {
+    for (int i = 0; i <= left->size; i++) children[childTotal++] = left->childNodes[i];
+    for (int i = 0; i <= right->size; i++) children[childTotal++] = right->childNodes[i];
+  }
+  // The only child of the emptied node, which might be empty itself
+  int grandChild = index > 0 ? left->size + 1 : 0;
+
+  removeKeyAndChild(parent, separator, separator + 1);
+  releaseNode(right);
+
+  char *separatorKey;
+  char *separatorDescription;
+  BTreeNode *newRight = distributeEntries(left, keys, descriptions, children, total, &separatorKey,
+                                          &separatorDescription);
+  if (newRight != NULL) {
+    insertKeyAndChild(parent, separator, separatorKey, separatorDescription, newRight);
+  }
+
+  if (!left->leaf) {
+    if (grandChild <= left->size) {
+      repairChild(tree, left, grandChild);
+    } else {
+      repairChild(tree, newRight, grandChild - left->size - 1);
+    }
+  }
+}
+
+/**
+ * Join two subtrees of the same height without an entry in between (all keys of left are smaller than the keys of
+ * right). The result ends up in left and, if it doesn't fit in one node, in a new right node.
+ * @param tree The tree we are working in
+ * @param left The left subtree, which will contain the result
+ * @param right The right subtree, which is freed
+ * @param separatorKey Where the key of the separator is stored if we needed a new right node
+ * @param separatorDescription "-" the description "-"
+ * @return NULL if the result fits in left, the new right node otherwise
+ */
+static BTreeNode *joinNodes(BTree *tree, BTreeNode *left, BTreeNode *right, char **separatorKey,
+                            char **separatorDescription) {
+  char *innerKey = NULL;
+  char *innerDescription = NULL;
+  BTreeNode *innerRight = NULL;
+  if (!left->leaf) {
+    // The rightmost child of left and the leftmost child of right become neighbours, join them first
+    innerRight = joinNodes(tree, left->childNodes[left->size], right->childNodes[0], &innerKey, &innerDescription);
+  }
+
+  char *keys[2 * N + 1];
+  char *descriptions[2 * N + 1];
+  BTreeNode *children[2 * N + 2];
+
+  int total = 0;
+  int childTotal = 0;
+  for (int i = 0; i < left->size; i++, total++) {
+    keys[total] = left->dateKeys[i];
+    descriptions[total] = left->descriptionValues[i];
+  }
+  int joined = left->size;
+  if (!left->leaf) {
+    for (int i = 0; i <= left->size; i++) children[childTotal++] = left->childNodes[i];
+    if (innerRight != NULL) {
+      keys[total] = innerKey;
+      descriptions[total++] = innerDescription;
+      children[childTotal++] = innerRight;
+    }
+    for (int i = 1; i <= right->size; i++) children[childTotal++] = right->childNodes[i];
+  }
+  for (int i = 0; i < right->size; i++, total++) {
+    keys[total] = right->dateKeys[i];
+    descriptions[total] = right->descriptionValues[i];
+  }
+  releaseNode(right);
+
+  BTreeNode *newRight = distributeEntries(left, keys, descriptions, children, total, separatorKey,
+                                          separatorDescription);
+  if (!left->leaf) {
+    if (joined <= left->size) {
+      repairChild(tree, left, joined);
+    } else {
+      repairChild(tree, newRight, joined - left->size - 1);
+    }
+  }
+  return newRight;
+}
+
+/**
+ * Recursively remove all entries between start and end underneath a node. The node itself might end up without
+ * entries, the caller should repair it with repairChild.
+ * @param tree The tree we are working in
+ * @param node The node we are currently processing
+ * @param start The begin boundary (inclusive), NULL to start at the first entry
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if end itself should be removed too, 0 otherwise
+ */
+void removeRangeRecursive(BTree *tree, BTreeNode *node, char *start, char *end, int inclusiveEnd) {
+  int first = start == NULL ? 0 : boundIndex(node, start, 0); // First entry in the range
+  int last = boundIndex(node, end, inclusiveEnd) - 1; // Last entry in the range
+  node->recursiveSize = -1;
+
+  if (first > last) {
+    // No entries of this node are in the range, it is completely inside one child
+    if (!node->leaf) {
+      removeRangeRecursive(tree, node->childNodes[first], start, end, inclusiveEnd);
+      repairChild(tree, node, first);
+    }
+    return;
+  }
+
+  for (int i = first; i <= last; i++) {
+    free(node->dateKeys[i]);
+    free(node->descriptionValues[i]);
+    tree->size--;
+  }
+  if (node->leaf) {
+    for (int i = first; i <= last; i++) {
+      node->dateKeys[i] = NULL;
+      node->descriptionValues[i] = NULL;
+    }
+    for (int i = last + 1; i < node->size; i++) {
+      node->dateKeys[i - (last - first + 1)] = node->dateKeys[i];
+      node->descriptionValues[i - (last - first + 1)] = node->descriptionValues[i];
+      node->dateKeys[i] = NULL;
+      node->descriptionValues[i] = NULL;
+    }
+    node->size -= last - first + 1;
+    return;
+  }
+
+  // The children between the first and last entry lie completely within the range
+  for (int i = first + 1; i <= last; i++) {
+    detachNode(tree, &tree->detached, node->childNodes[i]);
+  }
+  BTreeNode *left = node->childNodes[first];
+  BTreeNode *right = node->childNodes[last + 1];
+  removeRangeRecursive(tree, left, start, end, inclusiveEnd);
+  removeRangeRecursive(tree, right, start, end, inclusiveEnd);
+
+  // Close the gap, left and right become neighbours without an entry in between
+  int removed = last - first + 1;
+  for (int i = first; i < node->size; i++) {
+    node->dateKeys[i] = i + removed < node->size ? node->dateKeys[i + removed] : NULL;
+    node->descriptionValues[i] = i + removed < node->size ? node->descriptionValues[i + removed] : NULL;
+  }
+  for (int i = first + 1; i <= node->size; i++) {
+    node->childNodes[i] = i + removed <= node->size ? node->childNodes[i + removed] : NULL;
+  }
+  node->size -= removed;
+
+  char *separatorKey;
+  char *separatorDescription;
+  BTreeNode *newRight = joinNodes(tree, left, right, &separatorKey, &separatorDescription);
+  if (newRight != NULL) {
+    insertKeyAndChild(node, first, separatorKey, separatorDescription, newRight);
+  }
+  repairChild(tree, node, first);
+}
+
+/**
+ * Hand a subtree that is cut out of a tree over to be freed later on.
+ * @param tree The tree the subtree was part of, its size is updated
+ * @param detached The list of subtrees that still have to be freed
+ * @param node The root of the subtree
+ */
+void detachNode(BTree *tree, DetachedNodes *detached, BTreeNode *node) {
+  if (tree != NULL) {
+    // The entries (and gravestones) we lose
+    tree->size -= node->recursiveEntries;
+  }
+
+  if (detached->size == detached->capacity) {
+    int newCapacity = detached->capacity > 0 ? detached->capacity * 2 : 16;
+    BTreeNode **newNodes = realloc(detached->nodes, sizeof(BTreeNode *) * newCapacity);
+    if (newNodes == NULL) {
+      exit(1);
+    }
+    detached->nodes = newNodes;
+    detached->capacity = newCapacity;
+  }
+  node->parent = NULL;
+  detached->nodes[detached->size++] = node;
+}
+
+/**
+ * Free detached subtrees, one node at a time.
+ * @param detached The list of subtrees that still have to be freed
+ * @param budget The maximum amount of nodes we may free, < 0 to free everything
+ * @return The amount of nodes freed
+ */
+int reclaimNodes(DetachedNodes *detached, int budget) {
+  int freed = 0;
+  while (detached->size > 0 && (budget < 0 || freed < budget)) {
+    BTreeNode *node = detached->nodes[--detached->size];
+    for (int i = 0; i < node->size; i++) {
+      free(node->dateKeys[i]);
+      free(node->descriptionValues[i]);
+    }
+    for (int i = 0; !node->leaf && i <= node->size; i++) {
+      detachNode(NULL, detached, node->childNodes[i]);
+    }
+    freeMessages(node);
+    releaseNode(node);
+    freed++;
+  }
+  return freed;
+}
+
+/**
+ * Free a bounded amount of the subtrees that are removed from a tree, so removing ranges doesn't stall.
+ * @param tree The tree whose removed subtrees we are freeing
+ * @param budget The maximum amount of nodes we may free
+ */
+void reclaimDetached(BTree *tree, int budget) {
+  if (tree->shards != NULL) {
+    shardedReclaim(tree->shards, budget);
+    return;
+  }
+  if (tree->hybrid != NULL) {
+    reclaimDetached(tree->hybrid->delta, budget);
+    return;
+  }
+  reclaimNodes(&tree->detached, budget);
+}
+
 /**
  * Update the recursiveSize field of all the parent nodes.
  * @param node The node where we should start with updating (this node will be updated too)
@@ -386,6 +890,21 @@ void updateRecursiveSizes(BTreeNode *node, int update) {
   }
 }
 
+/**
+ * Update the recursiveEntries and recursiveNodes fields of all the parent nodes.
+ * @param node The node where we should start with updating (this node will be updated too)
+ * @param entries The amount of entries that were added underneath the node
+ * @param nodes The amount of nodes that were added underneath the node
+ */
+void updateRecursiveCounts(BTreeNode *node, int entries, int nodes) {
+  BTreeNode *cur = node;
+  while (cur != NULL) {
+    cur->recursiveEntries += entries;
+    cur->recursiveNodes += nodes;
+    cur = cur->parent;
+  }
+}
+
 /**
  * Count the entries in the BTree between begin and end (both inclusive).
  * @param tree The Tree where we will be counting
@@ -394,6 +913,23 @@ void updateRecursiveSizes(BTreeNode *node, int update) {
  * @return The count of entries between begin and end
  */
 int countBetweenEntries(BTree *tree, char *begin, char *end) {
+  if (tree->shards != NULL) {
+    return shardedCountBetweenEntries(tree->shards, begin, end);
+  }
+  if (tree->bplus != NULL) {
+    return bplusCountBetweenEntries(tree->bplus, begin, end);
+  }
+  if (tree->paged != NULL) {
+    return pagedCountBetweenEntries(tree->paged, begin, end);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridCountBetweenEntries(tree->hybrid, begin, end);
+  }
+  if (tree->buffered) {
+    // The buffered writes within the range can change the count, so they are applied first
+    flushRange(tree, begin, end);
+  }
+
   int count = 0;
   if (tree->root->size > 0) {
     countBetweenRecursive(tree->root, begin, end, &count, 0, 0);
@@ -497,6 +1033,207 @@ int searchIndex(BTreeNode *node, char *search, int isStartIndex, int exactMatch)
   return -1;
 }
 
+/**
+ * Find the leftmost or rightmost leaf of the tree, it is cached until the edge changes.
+ * @param tree The tree we are searching in
+ * @param last 1 for the rightmost leaf, 0 for the leftmost leaf
+ * @return The leaf
+ */
+BTreeNode *edgeLeaf(BTree *tree, int last) {
+  BTreeNode **cached = last ? &tree->lastLeaf : &tree->firstLeaf;
+  if (*cached == NULL) {
+    BTreeNode *node = tree->root;
+    while (!node->leaf) {
+      node = node->childNodes[last ? node->size : 0];
+    }
+    *cached = node;
+  }
+  return *cached;
+}
+
+/**
+ * Hand an entry of a node to a visitor if it is live.
+ * @return 1 if the visitor counted the entry, 0 otherwise
+ */
+static int visitEntry(BTreeNode *node, int index, EntryVisitor visit, void *context) {
+  char *description = node->descriptionValues[index];
+  return description != NULL ? visit(node->dateKeys[index], description, context) : 0;
+}
+
+/**
+ * Visit the live entries of a subtree in order, subtrees without live entries are skipped.
+ * @param node The root of the subtree
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+static int visitSubtree(BTreeNode *node, int last, int count, EntryVisitor visit, void *context) {
+  if (node->recursiveSize == 0) {
+    return 0;
+  }
+  int visited = 0;
+  for (int step = 0; step <= node->size && visited < count; step++) {
+    // Forwards child i comes right before entry i, backwards child i comes right before entry i - 1
+    int child = last ? node->size - step : step;
+    if (!node->leaf) {
+      visited += visitSubtree(node->childNodes[child], last, count - visited, visit, context);
+    }
+    int index = last ? child - 1 : child;
+    if (visited < count && index >= 0 && index < node->size) {
+      visited += visitEntry(node, index, visit, context);
+    }
+  }
+  return visited;
+}
+
+/**
+ * Visit the live entries of the tree in order, starting at the cached edge leaf and climbing up along the edge.
+ */
+static int visitFromEdge(BTree *tree, int last, int count, EntryVisitor visit, void *context) {
+  BTreeNode *node = edgeLeaf(tree, last);
+  int visited = visitSubtree(node, last, count, visit, context);
+  while (visited < count && node->parent != NULL) {
+    // node is the first (or last) child of its parent, the rest of the parent comes after it
+    BTreeNode *parent = node->parent;
+    for (int step = 0; step < parent->size && visited < count; step++) {
+      int index = last ? parent->size - 1 - step : step;
+      visited += visitEntry(parent, index, visit, context);
+      if (visited < count) {
+        visited += visitSubtree(parent->childNodes[last ? index : index + 1], last, count - visited, visit, context);
+      }
+    }
+    node = parent;
+  }
+  return visited;
+}
+
+/**
+ * Visitor that remembers the date of the last entry it saw.
+ */
+static int rememberDate(char *date, char *description, void *context) {
+  (void) description;
+  memcpy(context, date, DATE);
+  return 1;
+}
+
+/**
+ * Apply the buffered writes on the first (or last) entries of the tree. We flush up to the count-th entry, if the
+ * flush removed entries the count-th entry moved further and we have to flush up to that one as well.
+ */
+static void flushEdge(BTree *tree, int last, int count) {
+  char bound[DATE];
+  while (visitFromEdge(tree, last, count, rememberDate, bound) == count) {
+    flushRange(tree, last ? bound : NULL, last ? NULL : bound);
+
+    char check[DATE];
+    if (visitFromEdge(tree, last, count, rememberDate, check) == count &&
+        (last ? strcmp(check, bound) >= 0 : strcmp(check, bound) <= 0)) {
+      return;
+    }
+  }
+  // There are less than count entries, all buffered writes count
+  flushRange(tree, NULL, NULL);
+}
+
+/**
+ * Visit the first or last live entries of the tree in order.
+ * @param tree The tree we are working in
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor, the date and description it gets are only valid during the call
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int edgeEntries(BTree *tree, int last, int count, EntryVisitor visit, void *context) {
+  if (count <= 0) {
+    return 0;
+  }
+  if (tree->shards != NULL) {
+    return shardedEdgeEntries(tree->shards, last, count, visit, context);
+  }
+  if (tree->bplus != NULL) {
+    return bplusEdgeEntries(tree->bplus, last, count, visit, context);
+  }
+  if (tree->paged != NULL) {
+    return pagedEdgeEntries(tree->paged, last, count, visit, context);
+  }
+  if (tree->hybrid != NULL) {
+    return hybridEdgeEntries(tree->hybrid, last, count, visit, context);
+  }
+  if (tree->buffered && tree->root->pendingMessages > 0) {
+    flushEdge(tree, last, count);
+  }
+  return visitFromEdge(tree, last, count, visit, context);
+}
+
+/**
+ * Visit the first live entries of the tree, from the oldest date on.
+ * @param tree The tree we are working in
+ * @param count The maximum amount of entries
+ * @param visit The visitor, the date and description it gets are only valid during the call
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int firstEntries(BTree *tree, int count, EntryVisitor visit, void *context) {
+  return edgeEntries(tree, 0, count, visit, context);
+}
+
+/**
+ * Visit the last live entries of the tree, from the latest date backwards.
+ * @param tree The tree we are working in
+ * @param count The maximum amount of entries
+ * @param visit The visitor, the date and description it gets are only valid during the call
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int lastEntries(BTree *tree, int count, EntryVisitor visit, void *context) {
+  return edgeEntries(tree, 1, count, visit, context);
+}
+
+/**
+ * Struct representing the entry firstEntry or lastEntry found
+ */
+typedef struct FoundEntry {
+    char *date; // Filled with the date of the entry
+    char *description; // The description of the entry, NULL if the tree is empty
+} FoundEntry;
+
+/**
+ * Visitor that keeps the entry it gets.
+ */
+static int keepEntry(char *date, char *description, void *context) {
+  FoundEntry *found = context;
+  memcpy(found->date, date, DATE);
+  found->description = description;
+  return 1;
+}
+
+/**
+ * Find the live entry with the oldest date.
+ * @param tree The tree we are searching in
+ * @param date Filled with the date of the entry, at least DATE characters
+ * @return The description of the entry or NULL if the tree is empty
+ */
+char *firstEntry(BTree *tree, char *date) {
+  FoundEntry found = {date, NULL};
+  edgeEntries(tree, 0, 1, keepEntry, &found);
+  return found.description;
+}
+
+/**
+ * Find the live entry with the latest date.
+ * @param tree The tree we are searching in
+ * @param date Filled with the date of the entry, at least DATE characters
+ * @return The description of the entry or NULL if the tree is empty
+ */
+char *lastEntry(BTree *tree, char *date) {
+  FoundEntry found = {date, NULL};
+  edgeEntries(tree, 1, 1, keepEntry, &found);
+  return found.description;
+}
+
 /**
  * Function for free-ing a node and all it's children recursively.
  * @param node The current node we are freeing
@@ -514,8 +1251,24 @@ void freeNode(BTreeNode *node) {
       freeNode(node->childNodes[i + 1]);
     }
   }
+  freeMessages(node);
   // Free the current node itself too
-  free(node);
+  releaseNode(node);
+}
+
+/**
+ * Give the memory of a node back. A node of a compaction shares its block with the other nodes of the compaction,
+ * the block is freed once all of them are released.
+ * @param node The node we want to free
+ */
+void releaseNode(BTreeNode *node) {
+  NodeArena *arena = node->arena;
+  if (arena == NULL) {
+    free(node);
+  } else if (--arena->live == 0) {
+    free(arena->nodes);
+    free(arena);
+  }
 }
 
 /**
@@ -523,8 +1276,41 @@ void freeNode(BTreeNode *node) {
  * @param tree The Tree we want to free
  */
 void freeBTree(BTree *tree) {
+  if (tree->shards != NULL) {
+    freeShardSet(tree->shards);
+    tree->shards = NULL;
+    free(tree);
+    return;
+  }
+  if (tree->bplus != NULL) {
+    freeBPlusTree(tree->bplus);
+    tree->bplus = NULL;
+    free(tree);
+    return;
+  }
+  if (tree->paged != NULL) {
+    freePagedTree(tree->paged);
+    tree->paged = NULL;
+    free(tree);
+    return;
+  }
+  if (tree->hybrid != NULL) {
+    freeHybrid(tree->hybrid);
+    tree->hybrid = NULL;
+    free(tree);
+    return;
+  }
+
+  if (tree->compaction != NULL) {
+    freeCompaction(tree->compaction);
+    tree->compaction = NULL;
+  }
   freeNode(tree->root);
   tree->root = NULL;
 
+  reclaimNodes(&tree->detached, -1);
+  free(tree->detached.nodes);
+  freeFilter(tree->filter);
+
   free(tree);
 }
\ No newline at end of file
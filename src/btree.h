@@ -5,31 +5,111 @@
 #include <stdio.h>
 #include <string.h>
 
-#define N 600
+#ifndef N
+#define N 600 // the maximum amount of entries in a node
+#endif
+#if N % 2 != 0 || N < 4
+#error "N should be even and at least 4, rebalanceRecursive splits a full node into halves of N / 2"
+#endif
 #define DATE 20
+#define RECLAIM_STEP 8 // amount of detached nodes freed per reclaimDetached step
 
 
 typedef struct BTreeNode BTreeNode;
 
+typedef struct ShardSet ShardSet;
+
+typedef struct Filter Filter;
+
+typedef struct BPlusTree BPlusTree;
+
+typedef struct PagedTree PagedTree;
+
+typedef struct Hybrid Hybrid;
+
+typedef struct NodeArena NodeArena;
+
+typedef struct Compaction Compaction;
+
+/**
+ * Struct representing a write that is buffered in an inner node in the write-optimized mode
+ */
+typedef struct BufferedMessage {
+    char *date; // The key of the entry
+    char *description; // The description to insert, NULL if the entry should be removed
+    int order; // The position of the message in the buffer, to keep messages on the same key in order
+} BufferedMessage;
+
+/**
+ * Function that is called for the entries at an edge of a tree, the date and description are only valid during the
+ * call. It returns 1 if the entry counts, 0 if it should be skipped.
+ */
+typedef int (*EntryVisitor)(char *date, char *description, void *context);
+
+/**
+ * Struct representing the aggregates over the live entries in and underneath a node, next to their amount in
+ * recursiveSize. They are associative: the aggregates of a node combine those of its children with its own entries.
+ * An entry has a numeric payload if its description starts with a number followed by a space or its end.
+ */
+typedef struct Aggregate {
+    long long bytes; // total length of the descriptions
+    int valued; // amount of entries with a numeric payload
+    double sum; // sum of the payloads
+    double min; // smallest payload, only valid if valued > 0
+    double max; // largest payload, only valid if valued > 0
+    int minCount; // amount of entries whose payload is min, so removing one of them rarely needs a recalculation
+    int maxCount; // amount of entries whose payload is max
+} Aggregate;
+
 /**
  * Struct representing a node within a BTree
  */
 struct BTreeNode {
     BTreeNode *parent; // pointer to the parent
     int size; // amount of entries in the node
-    int recursiveSize; // amount of nodes in and underneath this top
+    int recursiveSize; // amount of live entries in and underneath this top
+    int recursiveEntries; // amount of entries (gravestones included) in and underneath this top
+    int recursiveNodes; // amount of nodes in and underneath this top, this one included
+    Aggregate aggregate; // aggregates over the live entries in and underneath this top
     int leaf; // leaf: 1, not a leaf: 0
     char *dateKeys[N]; // The keys of the entries in the tree
     char *descriptionValues[N]; // The descriptions of the entries in the tree
     BTreeNode *childNodes[N + 1]; // Pointers to the N + 1 child nodes of the current node/ entries
+    BufferedMessage *messages; // Buffered writes on the entries underneath (only in inner nodes), or NULL
+    int messageCount; // amount of messages in the buffer
+    int messageCapacity; // allocated length of messages
+    int pendingMessages; // amount of buffered messages in and underneath this node
+    NodeArena *arena; // The block of nodes a compaction allocated this node in, NULL if it was allocated by itself
 };
 
+/**
+ * Struct representing subtrees that are cut out of a BTree and still have to be freed
+ */
+typedef struct DetachedNodes {
+    BTreeNode **nodes; // The roots of the detached subtrees
+    int size; // The amount of detached subtrees
+    int capacity; // The allocated length of nodes
+} DetachedNodes;
+
 /**
  * Struct representing a BTree
  */
 typedef struct BTree {
     BTreeNode *root; // Pointer to the root BTreeNode
     int size; // The total amount of entries in the tree
+    ShardSet *shards; // The time partitions if this tree is a sharded front-end, NULL otherwise
+    DetachedNodes detached; // Removed subtrees that are freed bit by bit by reclaimDetached
+    BTreeNode *firstLeaf; // The leftmost leaf, NULL if it has to be looked up again
+    BTreeNode *lastLeaf; // The rightmost leaf, NULL if it has to be looked up again
+    int buffered; // write-optimized mode: 1, writes go straight to the leafs: 0
+    Filter *filter; // Negative-lookup filter over the live keys, NULL if it is turned off
+    BPlusTree *bplus; // The B+ tree holding the entries if this tree uses the B+ tree engine, NULL otherwise
+    PagedTree *paged; // The paged B+ tree holding the entries in paged mode, NULL otherwise
+    Hybrid *hybrid; // The static index and delta holding the entries in the hybrid engine, NULL otherwise
+    Compaction *compaction; // The compaction that is rewriting the nodes, NULL if there is none
+    int compactBelow; // Start a compaction once the fill drops below this percentage, 0 to only compact on request
+    int compactCheck; // The amount of commands until the fill is checked again
+    char *snapshotDirectory; // The directory @ writes its snapshots to, NULL if @ is turned off
 } BTree;
 
 /*
@@ -44,6 +124,8 @@ BTreeNode *createBTreeNode(int leaf);
  */
 void insertEntry(BTree *tree, char *date, char *description);
 
+void insertEntryUnbuffered(BTree *tree, char *date, char *description);
+
 void addAndRebalanceRecursive(BTree *tree, BTreeNode *node, char *date, char *description,
                               BTreeNode *lChild, BTreeNode *rChild, int leafs);
 
@@ -57,6 +139,8 @@ void rebalanceRecursive(BTree *tree, BTreeNode *node, char *date, char *descript
 
 void updateRecursiveSizes(BTreeNode *node, int update);
 
+void updateRecursiveCounts(BTreeNode *node, int entries, int nodes);
+
 BTreeNode *searchNode(BTreeNode *node, char *search, int add, int recursive);
 
 void recalculateRecursiveSizes(BTreeNode *node);
@@ -71,6 +155,25 @@ char *getEntry(BTree *tree, char *date);
  */
 int removeEntry(BTree *tree, char *date);
 
+int removeEntryUnbuffered(BTree *tree, char *date);
+
+/*
+ * Functions for removal of ranges of entries
+ */
+int removeRange(BTree *tree, char *start, char *end);
+
+int expireBefore(BTree *tree, char *cutoff);
+
+int removeRangeBetween(BTree *tree, char *start, char *end, int inclusiveEnd);
+
+void removeRangeRecursive(BTree *tree, BTreeNode *node, char *start, char *end, int inclusiveEnd);
+
+void detachNode(BTree *tree, DetachedNodes *detached, BTreeNode *node);
+
+int reclaimNodes(DetachedNodes *detached, int budget);
+
+void reclaimDetached(BTree *tree, int budget);
+
 /*
  * Functions for counting between entries
  */
@@ -80,11 +183,28 @@ void countBetweenRecursive(BTreeNode *node, char *begin, char *end, int *count,
 
 int searchIndex(BTreeNode *node, char *search, int isStartIndex, int exactMatch);
 
+/*
+ * Functions for the entries at the edges of the tree
+ */
+int firstEntries(BTree *tree, int count, EntryVisitor visit, void *context);
+
+int lastEntries(BTree *tree, int count, EntryVisitor visit, void *context);
+
+char *firstEntry(BTree *tree, char *date);
+
+char *lastEntry(BTree *tree, char *date);
+
+int edgeEntries(BTree *tree, int last, int count, EntryVisitor visit, void *context);
+
+BTreeNode *edgeLeaf(BTree *tree, int last);
+
 /*
  * Functions for free-ing nodes, entries and the tree
  */
 void freeNode(BTreeNode *node);
 
+void releaseNode(BTreeNode *node);
+
 void freeBTree(BTree *tree);
 
 /*
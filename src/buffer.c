@@ -0,0 +1,392 @@
+#include "buffer.h"
+#include "util.h"
+#include "aggregate.h"
+
+/**
+ * Update the pendingMessages field of a node and all of its parents.
+ * @param node The node where we should start with updating
+ * @param update The value with which we will update the pendingMessages field
+ */
+static void updatePendingMessages(BTreeNode *node, int update) {
+  for (BTreeNode *cur = node; cur != NULL; cur = cur->parent) {
+    cur->pendingMessages += update;
+  }
+}
+
+/**
+ * Compare two buffered messages on their key, messages on the same key stay in the order they were buffered.
+ */
+static int compareMessages(const void *a, const void *b) {
+  const BufferedMessage *first = a;
+  const BufferedMessage *second = b;
+  int cmp = strcmp(first->date, second->date);
+  return cmp != 0 ? cmp : first->order - second->order;
+}
+
+/**
+ * Like boundIndex, but only search the entries from a given index on. The messages of a batch are sorted, so the
+ * index of the previous message is a lower bound for the next one.
+ * @param node The node we are searching in
+ * @param search The key we are searching
+ * @param from The index from where we search
+ * @return The index of the first entry that is not smaller than search
+ */
+static int boundIndexFrom(BTreeNode *node, char *search, int from) {
+  int start = from;
+  int stop = node->size;
+  while (start < stop) {
+    int mid = (start + stop) / 2;
+    if (strcmp(node->dateKeys[mid], search) < 0) {
+      start = mid + 1;
+    } else {
+      stop = mid;
+    }
+  }
+  return start;
+}
+
+/**
+ * Apply a write on an entry that is already in a node (live or a gravestone). Like overwriteEntry, an insert only
+ * takes effect on a gravestone.
+ * @param node The node the entry is in
+ * @param index The index of the entry
+ * @param date The date of the write, freed
+ * @param description The description to insert, NULL to remove the entry
+ */
+static void applyToEntry(BTreeNode *node, int index, char *date, char *description) {
+  free(date);
+  char *current = node->descriptionValues[index];
+  if (description != NULL) {
+    if (current == NULL) {
+      node->descriptionValues[index] = description;
+      updateRecursiveSizes(node, +1);
+      aggregateAdded(node, description);
+    }
+  } else if (current != NULL) {
+    node->descriptionValues[index] = NULL;
+    updateRecursiveSizes(node, -1);
+    aggregateRemoved(node, current);
+    free(current);
+  }
+}
+
+/**
+ * Add a message at the end of the buffer of a node, the buffer grows when it is full. Only the node itself counts
+ * the message as pending, the caller updates the parents.
+ * @param tree The tree we are writing in
+ * @param node The inner node that buffers the message
+ * @param date The date of the entry
+ * @param description The description to insert, NULL to remove the entry
+ */
+static void appendMessage(BTree *tree, BTreeNode *node, char *date, char *description) {
+  if (node->messageCount == node->messageCapacity) {
+    int capacity = node->messageCapacity == 0 ? 16 : node->messageCapacity * 2;
+    BufferedMessage *messages = realloc(node->messages, sizeof(BufferedMessage) * capacity);
+    if (messages == NULL) {
+      freeBTree(tree);
+      exit(1);
+    }
+    node->messages = messages;
+    node->messageCapacity = capacity;
+  }
+  BufferedMessage *message = &node->messages[node->messageCount];
+  message->date = date;
+  message->description = description;
+  message->order = node->messageCount;
+  node->messageCount++;
+  node->pendingMessages++;
+}
+
+/**
+ * Buffer a write in the root. A write on an entry of the root itself is done in place right away, all others travel
+ * down with the flushes until they reach the node their entry is in or the leaf it belongs in.
+ * @param tree The tree we are writing in, its root is not a leaf
+ * @param date The date of the entry
+ * @param description The description to insert, NULL to remove the entry
+ */
+void bufferMessage(BTree *tree, char *date, char *description) {
+  BTreeNode *root = tree->root;
+  int index = boundIndex(root, date, 0);
+  if (index < root->size && strcmp(root->dateKeys[index], date) == 0) {
+    applyToEntry(root, index, date, description);
+    return;
+  }
+  appendMessage(tree, root, date, description);
+  if (root->messageCount >= MESSAGE_BUFFER) {
+    flushMessages(tree, root);
+  }
+}
+
+/**
+ * Search the node right above the leafs a key belongs under, starting at the root. The key isn't in any of the
+ * nodes on the way down.
+ * @param tree The tree we are working in
+ * @param date The key
+ * @param upper Set to the first key after the node (NULL if there is none), the keys up to it belong under the node
+ * @param index Set to the index of the entry of date if it is in a node on the way, -1 otherwise
+ * @return The node that has date as entry or that is right above the leaf date belongs in
+ */
+static BTreeNode *searchBottomNode(BTree *tree, char *date, char **upper, int *index) {
+  BTreeNode *node = tree->root;
+  *upper = NULL;
+  while (1) {
+    int found = boundIndex(node, date, 0);
+    if (found < node->size && strcmp(node->dateKeys[found], date) == 0) {
+      *index = found;
+      return node;
+    }
+    if (found < node->size) {
+      *upper = node->dateKeys[found];
+    }
+    if (node->childNodes[found]->leaf) {
+      *index = -1;
+      return node;
+    }
+    node = node->childNodes[found];
+  }
+}
+
+/**
+ * Apply a sorted batch of messages of a node right above the leafs on its leafs. Every leaf is searched from the
+ * position of the previous message on and an insert only shifts the entries of the leaf after it. A leaf that is
+ * full is split as usual, then the node and its parents might be freed and the next message looks its node up from
+ * the root.
+ * @param tree The tree we are working in
+ * @param node The node the messages were buffered in
+ * @param messages The messages, sorted on key
+ * @param count The amount of messages
+ */
+static void applyToLeafs(BTree *tree, BTreeNode *node, BufferedMessage *messages, int count) {
+  char *upper = NULL; // The node holds the keys up to upper (NULL: all keys of the batch)
+  int childIndex = 0;
+  BTreeNode *leaf = NULL;
+  int position = 0;
+  for (int i = 0; i < count; i++) {
+    char *date = messages[i].date;
+    char *description = messages[i].description;
+    if (node == NULL || (upper != NULL && strcmp(date, upper) >= 0)) {
+      int index;
+      node = searchBottomNode(tree, date, &upper, &index);
+      if (index >= 0) {
+        // A split moved the entry up
+        applyToEntry(node, index, date, description);
+        node = NULL;
+        continue;
+      }
+      childIndex = 0;
+      leaf = NULL;
+    }
+
+    childIndex = boundIndexFrom(node, date, childIndex);
+    if (childIndex < node->size && strcmp(node->dateKeys[childIndex], date) == 0) {
+      applyToEntry(node, childIndex, date, description);
+      continue;
+    }
+    if (node->childNodes[childIndex] != leaf) {
+      leaf = node->childNodes[childIndex];
+      position = 0;
+    }
+    position = boundIndexFrom(leaf, date, position);
+    if (position < leaf->size && strcmp(leaf->dateKeys[position], date) == 0) {
+      applyToEntry(leaf, position, date, description);
+    } else if (description == NULL) {
+      // Removal of an entry that is not in the tree
+      free(date);
+    } else if (leaf->size < N) {
+      memmove(&leaf->dateKeys[position + 1], &leaf->dateKeys[position], sizeof(char *) * (leaf->size - position));
+      memmove(&leaf->descriptionValues[position + 1], &leaf->descriptionValues[position],
+              sizeof(char *) * (leaf->size - position));
+      leaf->dateKeys[position] = date;
+      leaf->descriptionValues[position] = description;
+      leaf->size++;
+      updateRecursiveSizes(leaf, +1);
+      updateRecursiveCounts(leaf, +1, 0);
+      aggregateAdded(leaf, description);
+      tree->size += 1;
+    } else {
+      addAndRebalanceRecursive(tree, leaf, date, description, NULL, NULL, 1);
+      tree->size += 1;
+      node = NULL;
+    }
+  }
+}
+
+/**
+ * Flush the buffer of a node: its messages are sorted and pushed one level down, into the buffers of its children
+ * or (right above the leafs) into the leafs themselves. Children whose buffer gets full are flushed in turn, so a
+ * batch travels down without going back to the root. The node might be split (and freed) while flushing.
+ * @param tree The tree we are working in
+ * @param node The node whose buffer we are flushing
+ */
+void flushMessages(BTree *tree, BTreeNode *node) {
+  BufferedMessage *messages = node->messages;
+  int count = node->messageCount;
+  if (count == 0) {
+    return;
+  }
+
+  // Take the buffer out of the node first, splits caused by the messages only see an empty buffer
+  node->messages = NULL;
+  node->messageCount = 0;
+  node->messageCapacity = 0;
+  qsort(messages, count, sizeof(BufferedMessage), compareMessages);
+
+  if (node->childNodes[0]->leaf) {
+    updatePendingMessages(node, -count);
+    applyToLeafs(tree, node, messages, count);
+    free(messages);
+    return;
+  }
+
+  int index = 0;
+  int applied = 0;
+  for (int i = 0; i < count; i++) {
+    index = boundIndexFrom(node, messages[i].date, index);
+    if (index < node->size && strcmp(node->dateKeys[index], messages[i].date) == 0) {
+      applyToEntry(node, index, messages[i].date, messages[i].description);
+      applied++;
+    } else {
+      appendMessage(tree, node->childNodes[index], messages[i].date, messages[i].description);
+    }
+  }
+  // The routed messages are still pending underneath the node, only the applied ones are gone
+  updatePendingMessages(node, -applied);
+  free(messages);
+
+  // Flushing a child might split the node, its children stay
+  BTreeNode *full[N + 1];
+  int fullCount = 0;
+  for (int i = 0; i <= node->size; i++) {
+    if (node->childNodes[i]->messageCount >= MESSAGE_BUFFER) {
+      full[fullCount++] = node->childNodes[i];
+    }
+  }
+  for (int i = 0; i < fullCount; i++) {
+    flushMessages(tree, full[i]);
+  }
+}
+
+/**
+ * Search the highest node with buffered messages underneath which there are keys between begin and end.
+ * @param node The node where we start searching
+ * @param begin The begin boundary, NULL if there is none
+ * @param end The end boundary, NULL if there is none
+ * @return The node or NULL if there are no such messages
+ */
+static BTreeNode *searchPendingNode(BTreeNode *node, char *begin, char *end) {
+  if (node->pendingMessages == 0) {
+    return NULL;
+  }
+  if (node->messageCount > 0) {
+    return node;
+  }
+  int first = begin == NULL ? 0 : boundIndex(node, begin, 0);
+  int last = end == NULL ? node->size : boundIndex(node, end, 1);
+  for (int i = first; i <= last; i++) {
+    BTreeNode *found = searchPendingNode(node->childNodes[i], begin, end);
+    if (found != NULL) {
+      return found;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Apply all buffered messages on keys between begin and end. Every flush can restructure the tree, so we search
+ * again from the root after each one.
+ * @param tree The tree we are working in
+ * @param begin The begin boundary, NULL if there is none
+ * @param end The end boundary, NULL if there is none
+ */
+void flushRange(BTree *tree, char *begin, char *end) {
+  BTreeNode *node;
+  while ((node = searchPendingNode(tree->root, begin, end)) != NULL) {
+    flushMessages(tree, node);
+  }
+}
+
+/**
+ * Find the description of an entry underneath a node and replay the buffered messages on it. Messages deeper down
+ * are older, and there are none on an entry underneath the node the entry is in (the node itself can have newer
+ * ones, if the entry was moved up by a split).
+ * @param node The node we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description or NULL if date is not found
+ */
+static char *replayMessages(BTreeNode *node, char *date) {
+  int index = boundIndex(node, date, 0);
+  char *value;
+  if (index < node->size && strcmp(node->dateKeys[index], date) == 0) {
+    value = node->descriptionValues[index];
+  } else if (node->leaf) {
+    return NULL;
+  } else {
+    value = replayMessages(node->childNodes[index], date);
+  }
+  for (int i = 0; i < node->messageCount; i++) {
+    BufferedMessage *message = &node->messages[i];
+    if (strcmp(message->date, date) == 0) {
+      if (message->description == NULL) {
+        value = NULL;
+      } else if (value == NULL) {
+        // Like overwriteEntry, an insert only takes effect if there is no entry yet (or a gravestone)
+        value = message->description;
+      }
+    }
+  }
+  return value;
+}
+
+/**
+ * Find the description of an entry, taking the buffered messages into account.
+ * @param tree The BTree we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description or NULL if date is not found
+ */
+char *bufferedGetEntry(BTree *tree, char *date) {
+  return replayMessages(tree->root, date);
+}
+
+/**
+ * Remove an entry of the tree by buffering a removal. We look the entry up first, since we have to tell whether it
+ * was in the tree.
+ * @param tree The Tree where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not in Tree), 1 if succeeded
+ */
+int bufferedRemoveEntry(BTree *tree, char *date) {
+  if (tree->root->leaf) {
+    return removeEntryUnbuffered(tree, date);
+  }
+  if (bufferedGetEntry(tree, date) == NULL) {
+    return 0;
+  }
+
+  // The message gets its own copy of the date, the caller frees date
+  char *copy = malloc(sizeof(char) * DATE);
+  if (copy == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  memcpy(copy, date, DATE);
+  bufferMessage(tree, copy, NULL);
+  return 1;
+}
+
+/**
+ * Free the buffered messages of a node.
+ * @param node The node whose buffer we are freeing
+ */
+void freeMessages(BTreeNode *node) {
+  if (node->messages == NULL) {
+    return;
+  }
+  for (int i = 0; i < node->messageCount; i++) {
+    free(node->messages[i].date);
+    free(node->messages[i].description);
+  }
+  free(node->messages);
+  node->messages = NULL;
+  node->messageCount = 0;
+  node->messageCapacity = 0;
+}
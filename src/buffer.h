@@ -0,0 +1,25 @@
+#ifndef BTREE_BUFFER_H
+#define BTREE_BUFFER_H
+
+#include "btree.h"
+
+#ifndef MESSAGE_BUFFER
+#define MESSAGE_BUFFER 256 // amount of pending messages an inner node can hold before it is flushed
+#endif
+
+/*
+ * Functions for the write-optimized mode, where the inner nodes buffer the writes on the entries underneath
+ */
+void bufferMessage(BTree *tree, char *date, char *description);
+
+void flushMessages(BTree *tree, BTreeNode *node);
+
+void flushRange(BTree *tree, char *begin, char *end);
+
+char *bufferedGetEntry(BTree *tree, char *date);
+
+int bufferedRemoveEntry(BTree *tree, char *date);
+
+void freeMessages(BTreeNode *node);
+
+#endif //BTREE_BUFFER_H
@@ -0,0 +1,443 @@
+#include "command.h"
+#include "protocol.h"
+#include "compact.h"
+#include "aggregate.h"
+#include "snapshot.h"
+
+/**
+ * Copy a date out of a command line.
+ * @param tree The tree we are working on, freed if we are out of memory
+ * @param line The command line
+ * @param offset The index of the first character of the date in line
+ * @return The date, the caller should free it
+ */
+static char *copyDate(BTree *tree, char *line, int offset) {
+  char *date = malloc(sizeof(char) * DATE);
+  if (date == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  memcpy(date, &line[offset], DATE - 1);
+  date[DATE - 1] = '\0';
+  return date;
+}
+
+/**
+ * Parse the amount of entries of a [ or ] command, the rest of the line.
+ * @param text The text after the command character
+ * @param count Set to the amount, 1 if the line ends right away
+ * @return 1 if succeeded, 0 if the text is no amount
+ */
+static int parseCount(char *text, int *count) {
+  long amount = 0;
+  int digits = 0;
+  for (; *text >= '0' && *text <= '9'; text++, digits++) {
+    amount = amount * 10 + (*text - '0');
+    if (amount > INT32_MAX) {
+      amount = INT32_MAX;
+    }
+  }
+  if (*text != '\0' && *text != '\n') {
+    return 0;
+  }
+  *count = digits > 0 ? (int) amount : 1;
+  return 1;
+}
+
+/**
+ * Visitor that prints an entry of [ or ] as a line of the line protocol.
+ */
+static int printEdgeEntry(char *date, char *description, void *context) {
+  fprintf(context, "!%s %s\n", date, description);
+  return 1;
+}
+
+/**
+ * Execute one command (= line, including its line end) on the tree and write the answer.
+ * @param tree The tree we are working on
+ * @param line The command
+ * @param out Where the answer is written to
+ * @return COMMAND_DONE, COMMAND_EXIT if the line was empty or COMMAND_INVALID if it could not be parsed
+ */
+int executeCommand(BTree *tree, char *line, FILE *out) {
+  // Free a bit of the removed ranges and compact a bit before every command
+  reclaimDetached(tree, RECLAIM_STEP);
+  compactStep(tree, COMPACT_STEP);
+
+  char *date;
+  char *sdate;
+  size_t length = strlen(line);
+
+  switch (*line) {
+    case '+': {
+      if (length < DATE + 2) {
+        return COMMAND_INVALID;
+      }
+
+      // We willen een date met description toevoegen
+      date = copyDate(tree, line, 1);
+      char *description = malloc(sizeof(char) * (length - DATE - 1));
+      if (description == NULL) {
+        freeBTree(tree);
+        exit(1);
+      }
+      memcpy(description, &line[1 + DATE], length - DATE - 2);
+      description[length - DATE - 2] = '\0';
+
+      insertEntry(tree, date, description);
+      return COMMAND_DONE;
+    }
+    case '-':
+      if (length < DATE) {
+        return COMMAND_INVALID;
+      }
+
+      // We willen een date verwijderen
+      date = copyDate(tree, line, 1);
+      fprintf(out, removeEntry(tree, date) ? "-\n" : "?\n");
+      free(date);
+      return COMMAND_DONE;
+    case '?': {
+      if (length < DATE) {
+        return COMMAND_INVALID;
+      }
+
+      // We willen kijken of een bepaalde date in de boom zit
+      date = copyDate(tree, line, 1);
+      char *result = getEntry(tree, date);
+      if (result != NULL) {
+        fprintf(out, "!%s\n", result);
+      } else {
+        fprintf(out, "?\n");
+      }
+      free(date);
+      return COMMAND_DONE;
+    }
+    case '#':
+    case '$':
+    case '/':
+      if (length < DATE + DATE + 1) {
+        return COMMAND_INVALID;
+      }
+      date = copyDate(tree, line, 1);
+      sdate = copyDate(tree, line, 1 + DATE);
+      if (strcmp(date, sdate) > 0) {
+        char *swap = date;
+        date = sdate;
+        sdate = swap;
+      }
+
+      if (*line == '#') {
+        fprintf(out, "%i\n", countBetweenEntries(tree, date, sdate));
+      } else if (*line == '$') {
+        // We willen de aggregaten van alle dates tussen twee dates
+        Aggregate aggregate;
+        int amount = aggregateBetweenEntries(tree, date, sdate, &aggregate);
+        printAggregate(out, amount, aggregate.bytes, aggregate.valued, aggregate.sum, aggregate.min, aggregate.max);
+      } else {
+        // We willen alle dates tussen twee dates verwijderen
+        fprintf(out, "%i\n", removeRange(tree, date, sdate));
+      }
+      free(date);
+      free(sdate);
+      return COMMAND_DONE;
+    case '<':
+      if (length < DATE) {
+        return COMMAND_INVALID;
+      }
+
+      // We willen alle dates ouder dan een date verwijderen
+      date = copyDate(tree, line, 1);
+      fprintf(out, "%i\n", expireBefore(tree, date));
+      free(date);
+      return COMMAND_DONE;
+    case '%': {
+      // Hoe vol zitten de toppen van de boom
+      int fill = treeFill(tree);
+      if (fill >= 0) {
+        fprintf(out, "%i\n", fill);
+      } else {
+        fprintf(out, "?\n");
+      }
+      return COMMAND_DONE;
+    }
+    case '*':
+      startCompaction(tree);
+      return COMMAND_DONE;
+    case '@': {
+      // We willen een snapshot van de live entries wegschrijven, de rest van de regel is de naam
+      size_t nameLength = line[length - 1] == '\n' ? length - 2 : length - 1;
+      if (nameLength == 0) {
+        return COMMAND_INVALID;
+      }
+      char *name = malloc(sizeof(char) * (nameLength + 1));
+      if (name == NULL) {
+        freeBTree(tree);
+        exit(1);
+      }
+      memcpy(name, &line[1], nameLength);
+      name[nameLength] = '\0';
+      long long entries = saveNamedSnapshot(tree, name);
+      if (entries >= 0) {
+        fprintf(out, "%lld\n", entries);
+      } else {
+        fprintf(out, "?\n");
+      }
+      free(name);
+      return COMMAND_DONE;
+    }
+    case '[':
+    case ']': {
+      // We willen de oudste of nieuwste entries zien
+      int count;
+      if (!parseCount(&line[1], &count)) {
+        return COMMAND_INVALID;
+      }
+      if (edgeEntries(tree, *line == ']', count, printEdgeEntry, out) == 0) {
+        fprintf(out, "?\n");
+      }
+      return COMMAND_DONE;
+    }
+    case EOF:
+    case '\0':
+    case '\n':
+      return COMMAND_EXIT;
+    default:
+      return COMMAND_INVALID;
+  }
+}
+
+/**
+ * Unpack a date out of a binary command.
+ * @param tree The tree we are working on, freed if we are out of memory
+ * @param bytes The packed date
+ * @return The date, the caller should free it
+ */
+static char *unpackCommandDate(BTree *tree, unsigned char *bytes) {
+  char *date = malloc(sizeof(char) * DATE);
+  if (date == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  unpackDate(readU64(bytes), date);
+  return date;
+}
+
+/**
+ * Write a binary answer that consists of a tag and an optional u32.
+ */
+static void writeAnswer(FILE *out, unsigned char tag, int hasValue, uint32_t value) {
+  unsigned char answer[5] = {tag};
+  writeU32(&answer[1], value);
+  fwrite(answer, 1, hasValue ? 5 : 1, out);
+}
+
+/**
+ * Visitor that writes an entry of [ or ] in the binary protocol.
+ */
+static int writeEdgeEntry(char *date, char *description, void *context) {
+  unsigned char header[12];
+  uint64_t packed = 0;
+  packDate(date, &packed);
+  writeU64(header, packed);
+  uint32_t length = strlen(description);
+  writeU32(&header[8], length);
+  fwrite(header, 1, sizeof(header), context);
+  fwrite(description, 1, length, context);
+  return 1;
+}
+
+/**
+ * Write the binary answer of [ or ]: the amount of entries, followed by the entries.
+ * @param tree The tree we are working on
+ * @param last 1 for the last entries, 0 for the first entries
+ * @param count The maximum amount of entries
+ * @param answers Where the answer is written to
+ */
+static void writeEdgeAnswer(BTree *tree, int last, uint32_t count, FILE *answers) {
+  char *entries = NULL;
+  size_t entriesLength = 0;
+  FILE *entryStream = open_memstream(&entries, &entriesLength);
+  if (entryStream == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  int amount = edgeEntries(tree, last, count > INT32_MAX ? INT32_MAX : (int) count, writeEdgeEntry, entryStream);
+  fclose(entryStream);
+  writeAnswer(answers, amount > 0 ? '[' : '?', amount > 0, amount);
+  fwrite(entries, 1, entriesLength, answers);
+  free(entries);
+}
+
+/**
+ * Write the binary answer of $.
+ * @param tree The tree we are working on
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param answers Where the answer is written to
+ */
+static void writeAggregateAnswer(BTree *tree, char *begin, char *end, FILE *answers) {
+  Aggregate aggregate;
+  int amount = aggregateBetweenEntries(tree, begin, end, &aggregate);
+  unsigned char answer[41] = {'$'};
+  writeU32(&answer[1], amount);
+  writeU64(&answer[5], aggregate.bytes);
+  writeU32(&answer[13], aggregate.valued);
+  writeF64(&answer[17], aggregate.sum);
+  writeF64(&answer[25], aggregate.min);
+  writeF64(&answer[33], aggregate.max);
+  fwrite(answer, 1, sizeof(answer), answers);
+}
+
+/**
+ * Execute one command of a binary frame and write its answer.
+ * @param tree The tree we are working on
+ * @param command The command, commandLength has checked it
+ * @param answers Where the answer is written to
+ * @return 1 if the command has an answer, 0 otherwise
+ */
+static int executeBinaryCommand(BTree *tree, unsigned char *command, FILE *answers) {
+  // Free a bit of the removed ranges and compact a bit before every command
+  reclaimDetached(tree, RECLAIM_STEP);
+  compactStep(tree, COMPACT_STEP);
+
+  if (command[0] == '%') {
+    int fill = treeFill(tree);
+    writeAnswer(answers, fill >= 0 ? '#' : '?', fill >= 0, fill);
+    return 1;
+  }
+  if (command[0] == '*') {
+    startCompaction(tree);
+    return 0;
+  }
+  if (command[0] == '[' || command[0] == ']') {
+    writeEdgeAnswer(tree, command[0] == ']', readU32(&command[1]), answers);
+    return 1;
+  }
+  if (command[0] == '@') {
+    uint32_t length = readU32(&command[1]);
+    char *name = malloc(sizeof(char) * (length + 1));
+    if (name == NULL) {
+      freeBTree(tree);
+      exit(1);
+    }
+    memcpy(name, &command[5], length);
+    name[length] = '\0';
+    long long entries = saveNamedSnapshot(tree, name);
+    writeAnswer(answers, entries >= 0 ? '#' : '?', entries >= 0, entries);
+    free(name);
+    return 1;
+  }
+
+  char *date = unpackCommandDate(tree, &command[1]);
+  switch (command[0]) {
+    case '+': {
+      uint32_t length = readU32(&command[9]);
+      char *description = malloc(sizeof(char) * (length + 1));
+      if (description == NULL) {
+        freeBTree(tree);
+        exit(1);
+      }
+      memcpy(description, &command[13], length);
+      description[length] = '\0';
+      insertEntry(tree, date, description);
+      return 0;
+    }
+    case '-':
+      writeAnswer(answers, removeEntry(tree, date) ? '-' : '?', 0, 0);
+      break;
+    case '?': {
+      char *result = getEntry(tree, date);
+      if (result != NULL) {
+        uint32_t length = strlen(result);
+        writeAnswer(answers, '!', 1, length);
+        fwrite(result, 1, length, answers);
+      } else {
+        writeAnswer(answers, '?', 0, 0);
+      }
+      break;
+    }
+    case '#':
+    case '/': {
+      char *sdate = unpackCommandDate(tree, &command[9]);
+      if (strcmp(date, sdate) > 0) {
+        char *swap = date;
+        date = sdate;
+        sdate = swap;
+      }
+      int amount = command[0] == '#' ? countBetweenEntries(tree, date, sdate) : removeRange(tree, date, sdate);
+      writeAnswer(answers, '#', 1, amount);
+      free(sdate);
+      break;
+    }
+    case '$': {
+      char *sdate = unpackCommandDate(tree, &command[9]);
+      if (strcmp(date, sdate) > 0) {
+        char *swap = date;
+        date = sdate;
+        sdate = swap;
+      }
+      writeAggregateAnswer(tree, date, sdate, answers);
+      free(sdate);
+      break;
+    }
+    case '<':
+      writeAnswer(answers, '#', 1, expireBefore(tree, date));
+      break;
+  }
+  free(date);
+  return 1;
+}
+
+/**
+ * Execute the commands of a binary frame and write one frame with their answers. The frame is checked before any
+ * of its commands is executed.
+ * @param tree The tree we are working on
+ * @param frame The frame, without the length in front of it
+ * @param length The length of the frame
+ * @param out Where the answer frame is written to
+ * @return COMMAND_DONE, COMMAND_EXIT if the frame had no commands or COMMAND_INVALID if it could not be parsed
+ */
+int executeFrame(BTree *tree, unsigned char *frame, size_t length, FILE *out) {
+  if (length < FRAME_HEADER - FRAME_LENGTH) {
+    return COMMAND_INVALID;
+  }
+  uint32_t count = readU32(frame);
+  size_t offset = FRAME_HEADER - FRAME_LENGTH;
+  for (uint32_t i = 0; i < count; i++) {
+    int commandSize = commandLength(&frame[offset], length - offset);
+    if (commandSize < 0) {
+      return COMMAND_INVALID;
+    }
+    offset += commandSize;
+  }
+  if (offset != length) {
+    return COMMAND_INVALID;
+  }
+  if (count == 0) {
+    return COMMAND_EXIT;
+  }
+
+  char *answers = NULL;
+  size_t answersLength = 0;
+  FILE *answerStream = open_memstream(&answers, &answersLength);
+  if (answerStream == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  uint32_t answered = 0;
+  offset = FRAME_HEADER - FRAME_LENGTH;
+  for (uint32_t i = 0; i < count; i++) {
+    answered += executeBinaryCommand(tree, &frame[offset], answerStream);
+    offset += commandLength(&frame[offset], length - offset);
+  }
+  fclose(answerStream);
+
+  unsigned char header[FRAME_HEADER];
+  writeU32(header, answersLength + FRAME_HEADER - FRAME_LENGTH);
+  writeU32(&header[4], answered);
+  fwrite(header, 1, FRAME_HEADER, out);
+  fwrite(answers, 1, answersLength, out);
+  free(answers);
+  return COMMAND_DONE;
+}
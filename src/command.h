@@ -0,0 +1,18 @@
+#ifndef BTREE_COMMAND_H
+#define BTREE_COMMAND_H
+
+#include "btree.h"
+
+// Results of executeCommand
+#define COMMAND_DONE 0 // the command was executed
+#define COMMAND_EXIT 1 // an empty line, the session should end
+#define COMMAND_INVALID 2 // the command could not be parsed, the session should end
+
+/*
+ * Functions for executing the commands of the line protocol and of the binary protocol (see protocol.h)
+ */
+int executeCommand(BTree *tree, char *line, FILE *out);
+
+int executeFrame(BTree *tree, unsigned char *frame, size_t length, FILE *out);
+
+#endif //BTREE_COMMAND_H
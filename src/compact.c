@@ -0,0 +1,502 @@
+#include "compact.h"
+#include "util.h"
+#include "buffer.h"
+#include "aggregate.h"
+#include <limits.h>
+
+/**
+ * Copy a string for the new tree.
+ * @param tree The tree we are compacting, freed if we are out of memory
+ * @param string The string, NULL is copied as NULL
+ * @return The copy
+ */
+static char *copyString(BTree *tree, char *string) {
+  if (string == NULL) {
+    return NULL;
+  }
+  size_t length = strlen(string) + 1;
+  char *copy = malloc(sizeof(char) * length);
+  if (copy == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  memcpy(copy, string, length);
+  return copy;
+}
+
+/**
+ * The amount of entries a compaction puts in a node.
+ */
+static int nodeFill() {
+  int fill = N * COMPACT_FILL / 100;
+  return fill < 3 ? 3 : fill;
+}
+
+/**
+ * Calculate the height of a packed tree.
+ * @param count The amount of entries in the tree
+ * @param capacity Filled with the amount of entries a packed subtree of every height up to the result holds
+ * @return The height, 0 if the tree is one leaf
+ */
+static int planHeight(int count, long long *capacity) {
+  int height = 0;
+  capacity[0] = nodeFill();
+  while (capacity[height] < count) {
+    capacity[height + 1] = nodeFill() + (nodeFill() + 1) * capacity[height];
+    height++;
+  }
+  return height;
+}
+
+/**
+ * The amount of children of a node in a packed tree, as few as possible so the children are as full as possible.
+ */
+static int childrenOf(int count, int height, long long *capacity) {
+  long long children = (count + 1 + capacity[height - 1]) / (capacity[height - 1] + 1);
+  return children < 2 ? 2 : (int) children;
+}
+
+/**
+ * The amount of entries in and underneath a child of a node in a packed tree, the entries are spread evenly.
+ */
+static int childCount(int count, int children, int child) {
+  int total = count - (children - 1);
+  return total / children + (child < total % children ? 1 : 0);
+}
+
+/**
+ * The amount of nodes of a packed tree. The children of a node differ at most one entry in size (see childCount), so
+ * only two subtrees are counted per level instead of all nodes.
+ */
+static int plannedNodes(int count, int height, long long *capacity) {
+  if (height == 0) {
+    return 1;
+  }
+  int children = childrenOf(count, height, capacity);
+  int total = count - (children - 1);
+  int bigger = total % children;
+  int nodes = 1 + (children - bigger) * plannedNodes(total / children, height - 1, capacity);
+  if (bigger > 0) {
+    nodes += bigger * plannedNodes(total / children + 1, height - 1, capacity);
+  }
+  return nodes;
+}
+
+/**
+ * The fill of a tree: the live entries as a percentage of the entry slots of all of its nodes. Gravestones and
+ * half-full nodes after splits both lower it.
+ * @param tree The tree we are measuring
+ * @return The percentage or -1 if the tree doesn't keep its entries in BTreeNode's
+ */
+int treeFill(BTree *tree) {
+  if (tree->shards != NULL || tree->bplus != NULL || tree->paged != NULL || tree->hybrid != NULL) {
+    return -1;
+  }
+  long long slots = (long long) tree->root->recursiveNodes * N;
+  return (int) (tree->root->recursiveSize * 100LL / slots);
+}
+
+/**
+ * Start compacting a tree, the work is done by compactStep. Nothing happens if a compaction is running already or
+ * if the tree doesn't keep its entries in BTreeNode's.
+ * @param tree The tree we want to compact
+ */
+void startCompaction(BTree *tree) {
+  if (tree->compaction != NULL || tree->shards != NULL || tree->bplus != NULL || tree->paged != NULL ||
+      tree->hybrid != NULL) {
+    return;
+  }
+  Compaction *compaction = calloc(1, sizeof(Compaction));
+  if (compaction == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  if (tree->buffered && !tree->root->leaf) {
+    // The leafs have to hold all entries while they are copied
+    flushRange(tree, NULL, NULL);
+  }
+  compaction->buffered = tree->buffered;
+  tree->buffered = 0;
+  tree->compaction = compaction;
+}
+
+/**
+ * Copy the live entries after a key out of a node and underneath it, in order.
+ * @param tree The tree we are compacting
+ * @param node The node we are copying from
+ * @param after The last key that was copied before, NULL to start at the first entry
+ * @param budget The amount of entries we may still copy, lowered for every entry
+ * @return 1 if the budget ran out, 0 otherwise
+ */
+static int copyEntries(BTree *tree, BTreeNode *node, char *after, int *budget) {
+  Compaction *compaction = tree->compaction;
+  int first = after == NULL ? 0 : boundIndex(node, after, 1);
+  for (int i = first; i <= node->size; i++) {
+    if (!node->leaf && copyEntries(tree, node->childNodes[i], i == first ? after : NULL, budget)) {
+      return 1;
+    }
+    if (i == node->size) break;
+    if (node->descriptionValues[i] == NULL) continue;
+
+    if (compaction->entryCount == compaction->entryCapacity) {
+      int capacity = compaction->entryCapacity > 0 ? compaction->entryCapacity * 2 : 1024;
+      CompactedEntry *entries = realloc(compaction->entries, sizeof(CompactedEntry) * capacity);
+      if (entries == NULL) {
+        freeBTree(tree);
+        exit(1);
+      }
+      compaction->entries = entries;
+      compaction->entryCapacity = capacity;
+    }
+    CompactedEntry *entry = &compaction->entries[compaction->entryCount++];
+    entry->date = copyString(tree, node->dateKeys[i]);
+    entry->description = copyString(tree, node->descriptionValues[i]);
+    if (--*budget == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Log a write on the tree while it is compacted, if it touches the entries that were copied already. Call it before
+ * the write is done, the strings are copied.
+ * @param tree The tree that is written to
+ * @param command '+', '-' or '/'
+ * @param date The key, or the begin of the range of '/' (NULL from the first entry on)
+ * @param description The description of '+', NULL otherwise
+ * @param end The end of the range of '/', NULL otherwise
+ * @param inclusiveEnd 1 if an entry on end is removed by '/' as well
+ */
+void logCompactedWrite(BTree *tree, char command, char *date, char *description, char *end, int inclusiveEnd) {
+  Compaction *compaction = tree->compaction;
+  if (compaction == NULL) {
+    return;
+  }
+  if (!compaction->building) {
+    if (compaction->entryCount == 0) {
+      return;
+    }
+    // Everything after the cursor is still copied from the tree, so only the part up to it counts
+    char *cursor = compaction->entries[compaction->entryCount - 1].date;
+    if (date != NULL && strcmp(date, cursor) > 0) {
+      return;
+    }
+    if (end != NULL && strcmp(end, cursor) > 0) {
+      end = cursor;
+      inclusiveEnd = 1;
+    }
+  }
+
+  if (compaction->logSize == compaction->logCapacity) {
+    int capacity = compaction->logCapacity > 0 ? compaction->logCapacity * 2 : 64;
+    LoggedWrite *log = realloc(compaction->log, sizeof(LoggedWrite) * capacity);
+    if (log == NULL) {
+      freeBTree(tree);
+      exit(1);
+    }
+    compaction->log = log;
+    compaction->logCapacity = capacity;
+  }
+  LoggedWrite *write = &compaction->log[compaction->logSize++];
+  write->command = command;
+  write->date = copyString(tree, date);
+  write->description = copyString(tree, description);
+  write->end = copyString(tree, end);
+  write->inclusiveEnd = inclusiveEnd;
+}
+
+/**
+ * Plan the new tree once all entries are copied, its nodes are allocated at once.
+ */
+static void planTree(BTree *tree) {
+  Compaction *compaction = tree->compaction;
+  int height = planHeight(compaction->entryCount, compaction->capacity);
+  int nodes = plannedNodes(compaction->entryCount, height, compaction->capacity);
+  compaction->arena = malloc(sizeof(NodeArena));
+  if (compaction->arena == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  compaction->arena->nodes = calloc(nodes, sizeof(BTreeNode));
+  compaction->arena->size = 0;
+  compaction->arena->live = 0;
+  if (compaction->arena->nodes == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  compaction->stack[0] = (CompactionFrame) {NULL, 0, compaction->entryCount, height, 0, 0, 0};
+  compaction->depth = 1;
+  compaction->building = 1;
+}
+
+/**
+ * Take the node that is done off the stack, its parent goes on with its next child.
+ */
+static void popFrame(Compaction *compaction) {
+  CompactionFrame *frame = &compaction->stack[--compaction->depth];
+  // All children of the node are built, so its aggregate and node count can be calculated
+  BTreeNode *node = frame->node;
+  recalculateAggregate(node);
+  node->recursiveNodes = 1;
+  for (int i = 0; !node->leaf && i <= node->size; i++) {
+    node->recursiveNodes += node->childNodes[i]->recursiveNodes;
+  }
+  int count = frame->count;
+  if (compaction->depth > 0) {
+    CompactionFrame *parent = &compaction->stack[compaction->depth - 1];
+    parent->childFirst += count + 1;
+    parent->child++;
+  }
+}
+
+/**
+ * Build nodes of the new tree in depth-first order, a node is allocated before its children.
+ * @param compaction The compaction
+ * @param budget The amount of entries we may place in nodes
+ */
+static void buildNodes(Compaction *compaction, int budget) {
+  while (budget > 0 && compaction->depth > 0) {
+    CompactionFrame *frame = &compaction->stack[compaction->depth - 1];
+    if (frame->node == NULL) {
+      BTreeNode *node = &compaction->arena->nodes[compaction->arena->size++];
+      node->leaf = frame->height == 0;
+      node->recursiveSize = frame->count;
+      node->recursiveEntries = frame->count;
+      node->arena = compaction->arena;
+      compaction->arena->live++;
+      if (compaction->depth > 1) {
+        CompactionFrame *parent = &compaction->stack[compaction->depth - 2];
+        parent->node->childNodes[parent->child] = node;
+        node->parent = parent->node;
+      } else {
+        compaction->root = node;
+      }
+      frame->node = node;
+
+      if (node->leaf) {
+        for (int i = 0; i < frame->count; i++) {
+          node->dateKeys[i] = compaction->entries[frame->first + i].date;
+          node->descriptionValues[i] = compaction->entries[frame->first + i].description;
+        }
+        node->size = frame->count;
+        budget -= frame->count;
+        popFrame(compaction);
+        continue;
+      }
+
+      // The entries between the children go in the node itself
+      frame->children = childrenOf(frame->count, frame->height, compaction->capacity);
+      frame->child = 0;
+      frame->childFirst = frame->first;
+      int index = frame->first;
+      for (int i = 0; i < frame->children - 1; i++) {
+        index += childCount(frame->count, frame->children, i);
+        node->dateKeys[i] = compaction->entries[index].date;
+        node->descriptionValues[i] = compaction->entries[index].description;
+        index++;
+      }
+      node->size = frame->children - 1;
+      budget -= node->size;
+    }
+
+    if (frame->child == frame->children) {
+      popFrame(compaction);
+    } else {
+      compaction->stack[compaction->depth++] = (CompactionFrame) {
+          NULL, frame->childFirst, childCount(frame->count, frame->children, frame->child), frame->height - 1, 0, 0, 0
+      };
+    }
+  }
+}
+
+/**
+ * Start replaying the logged writes once all nodes of the new tree are built.
+ */
+static void startReplay(Compaction *compaction) {
+  BTree *built = &compaction->built;
+  built->root = compaction->root;
+  built->size = compaction->entryCount;
+  built->shards = NULL;
+  built->detached.nodes = NULL;
+  built->detached.size = 0;
+  built->detached.capacity = 0;
+  built->firstLeaf = NULL;
+  built->lastLeaf = NULL;
+  built->buffered = 0;
+  built->filter = NULL;
+  built->bplus = NULL;
+  built->paged = NULL;
+  built->hybrid = NULL;
+  built->compaction = NULL;
+  built->compactBelow = 0;
+  built->compactCheck = 0;
+  built->snapshotDirectory = NULL;
+  compaction->replayed = 0;
+}
+
+/**
+ * Replay a bounded amount of the logged writes on the new tree. Writes on the tree are still logged in the meantime,
+ * the log is drained as long as more writes are replayed per command than there are logged.
+ * @param compaction The compaction
+ * @param budget The amount of writes we may replay
+ */
+static void replayLog(Compaction *compaction, int budget) {
+  BTree *built = &compaction->built;
+  while (budget > 0 && compaction->replayed < compaction->logSize) {
+    LoggedWrite *write = &compaction->log[compaction->replayed++];
+    switch (write->command) {
+      case '+':
+        if (getEntry(built, write->date) == NULL) {
+          insertEntryUnbuffered(built, write->date, write->description);
+        } else {
+          free(write->date);
+          free(write->description);
+        }
+        break;
+      case '-':
+        removeEntryUnbuffered(built, write->date);
+        free(write->date);
+        break;
+      case '/':
+        removeRangeBetween(built, write->date, write->end, write->inclusiveEnd);
+        free(write->date);
+        free(write->end);
+        break;
+    }
+    budget--;
+  }
+}
+
+/**
+ * Let the new tree replace the old tree once the whole log is replayed, the old tree is freed by reclaimDetached.
+ */
+static void finishCompaction(BTree *tree) {
+  Compaction *compaction = tree->compaction;
+  tree->compaction = NULL;
+
+  BTree *built = &compaction->built;
+  for (int i = 0; i < built->detached.size; i++) {
+    detachNode(NULL, &tree->detached, built->detached.nodes[i]);
+  }
+  free(built->detached.nodes);
+
+  detachNode(NULL, &tree->detached, tree->root);
+  tree->root = built->root;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->size = built->size;
+  tree->buffered = compaction->buffered;
+  free(compaction->entries);
+  free(compaction->log);
+  free(compaction);
+}
+
+/**
+ * Fill an empty tree with sorted entries at once. The nodes are built like a compaction builds them, packed in
+ * depth-first order, without inserting the entries one by one.
+ * @param tree The tree, empty and keeping its entries in BTreeNode's
+ * @param entries The live entries in strictly increasing order, the tree owns the array and the strings afterwards
+ * @param count The amount of entries
+ */
+void buildTree(BTree *tree, CompactedEntry *entries, int count) {
+  Compaction *compaction = calloc(1, sizeof(Compaction));
+  if (compaction == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  compaction->entries = entries;
+  compaction->entryCount = count;
+  compaction->entryCapacity = count;
+  compaction->buffered = tree->buffered;
+  tree->buffered = 0;
+  tree->compaction = compaction;
+  planTree(tree);
+  buildNodes(compaction, INT_MAX);
+  startReplay(compaction);
+  finishCompaction(tree);
+}
+
+/**
+ * Check if compacting a tree is worth it: its fill is below the threshold and a packed tree would need less nodes.
+ */
+static int shouldCompact(BTree *tree) {
+  int fill = treeFill(tree);
+  if (fill < 0 || fill >= tree->compactBelow) {
+    return 0;
+  }
+  long long capacity[COMPACT_MAX_HEIGHT];
+  int live = tree->root->recursiveSize;
+  return tree->root->recursiveNodes > plannedNodes(live, planHeight(live, capacity), capacity);
+}
+
+/**
+ * Do a bounded amount of work on the compaction of a tree: copy entries, build nodes or replay logged writes.
+ * Without a compaction, the fill is checked once in a while if compactions start by themselves.
+ * @param tree The tree we are compacting
+ * @param budget The amount of entries we may copy or place in nodes, or of writes we may replay
+ */
+void compactStep(BTree *tree, int budget) {
+  Compaction *compaction = tree->compaction;
+  if (compaction == NULL) {
+    if (tree->compactBelow > 0 && --tree->compactCheck <= 0) {
+      tree->compactCheck = COMPACT_CHECK;
+      if (shouldCompact(tree)) {
+        startCompaction(tree);
+      }
+    }
+    return;
+  }
+
+  if (!compaction->building) {
+    char *after = compaction->entryCount > 0 ? compaction->entries[compaction->entryCount - 1].date : NULL;
+    if (!copyEntries(tree, tree->root, after, &budget)) {
+      // Everything is copied
+      planTree(tree);
+    }
+    return;
+  }
+  if (compaction->built.root == NULL) {
+    buildNodes(compaction, budget);
+    if (compaction->depth == 0) {
+      startReplay(compaction);
+    }
+    return;
+  }
+  replayLog(compaction, budget);
+  if (compaction->replayed == compaction->logSize) {
+    finishCompaction(tree);
+  }
+}
+
+/**
+ * Free a compaction that didn't finish, the tree is left as it is.
+ * @param compaction The compaction we want to free
+ */
+void freeCompaction(Compaction *compaction) {
+  if (compaction->built.root != NULL) {
+    // The new tree owns the copied entries and its nodes by now, it is freed like a removed subtree
+    detachNode(NULL, &compaction->built.detached, compaction->built.root);
+    reclaimNodes(&compaction->built.detached, -1);
+    free(compaction->built.detached.nodes);
+  } else {
+    for (int i = 0; i < compaction->entryCount; i++) {
+      free(compaction->entries[i].date);
+      free(compaction->entries[i].description);
+    }
+    if (compaction->arena != NULL) {
+      // The nodes only point to the copied entries
+      free(compaction->arena->nodes);
+      free(compaction->arena);
+    }
+  }
+  // The writes that are replayed already are owned by the new tree or freed
+  for (int i = compaction->replayed; i < compaction->logSize; i++) {
+    free(compaction->log[i].date);
+    free(compaction->log[i].description);
+    free(compaction->log[i].end);
+  }
+  free(compaction->entries);
+  free(compaction->log);
+  free(compaction);
+}
@@ -0,0 +1,97 @@
+#ifndef BTREE_COMPACT_H
+#define BTREE_COMPACT_H
+
+#include "btree.h"
+
+#ifndef COMPACT_STEP
+#define COMPACT_STEP 128 // amount of entries a compaction copies or places in nodes per command
+#endif
+#ifndef COMPACT_FILL
+#define COMPACT_FILL 90 // percentage of the N slots of a node a compaction fills, room for inserts without splits
+#endif
+#ifndef COMPACT_CHECK
+#define COMPACT_CHECK 4096 // amount of commands between two checks of the fill, if compactions start by themselves
+#endif
+#define COMPACT_MAX_HEIGHT 32 // the compacted tree can't get higher than this
+
+/**
+ * Struct representing a block of nodes that a compaction allocated at once, in depth-first order
+ */
+struct NodeArena {
+    BTreeNode *nodes; // The nodes
+    int size; // The amount of nodes handed out
+    int live; // The amount of nodes that are not released yet, the block is freed when it drops to 0
+};
+
+/**
+ * Struct representing a live entry that was copied out of the tree
+ */
+typedef struct CompactedEntry {
+    char *date; // Copy of the key
+    char *description; // Copy of the description
+} CompactedEntry;
+
+/**
+ * Struct representing a write on the part of the tree that was already copied, it is replayed on the new tree
+ */
+typedef struct LoggedWrite {
+    char command; // '+', '-' or '/'
+    char *date; // The key, or the begin of the range of '/' (NULL from the first entry on)
+    char *description; // The description of '+', NULL otherwise
+    char *end; // The end of the range of '/', NULL otherwise
+    int inclusiveEnd; // 1 if an entry on end is removed by '/' as well
+} LoggedWrite;
+
+/**
+ * Struct representing a node of the new tree whose children are being built
+ */
+typedef struct CompactionFrame {
+    BTreeNode *node; // The node, NULL until it is allocated
+    int first; // The index of the first entry underneath the node
+    int count; // The amount of entries in and underneath the node
+    int height; // The height of the node, 0 for a leaf
+    int children; // The amount of children of the node
+    int child; // The child that is built next
+    int childFirst; // The index of the first entry underneath the next child
+} CompactionFrame;
+
+/**
+ * Struct representing a compaction that rewrites a BTree into densely packed nodes, a few entries per command. The
+ * live entries are copied in order first, then the nodes are built in depth-first order from one block of memory.
+ * Writes on the part that was already copied are logged and replayed on the new tree, a few per command as well,
+ * before it replaces the old one.
+ */
+typedef struct Compaction {
+    int building; // 0 while the entries are copied, 1 while the nodes are built and the log is replayed
+    CompactedEntry *entries; // The copied entries, in order
+    int entryCount; // The amount of copied entries
+    int entryCapacity; // The allocated length of entries
+    LoggedWrite *log; // The writes on the copied part
+    int logSize; // The amount of logged writes
+    int logCapacity; // The allocated length of log
+    NodeArena *arena; // The nodes of the new tree
+    BTreeNode *root; // The root of the new tree
+    long long capacity[COMPACT_MAX_HEIGHT]; // The amount of entries a packed subtree of every height holds
+    CompactionFrame stack[COMPACT_MAX_HEIGHT]; // The path from the root to the node that is built now
+    int depth; // The amount of frames on the stack
+    int buffered; // The write mode of the tree, writes go straight to the leafs during a compaction
+    BTree built; // The new tree while the log is replayed on it, its root is NULL until all nodes are built
+    int replayed; // The amount of logged writes that are replayed on the new tree
+} Compaction;
+
+/*
+ * Functions for compacting a BTree
+ */
+int treeFill(BTree *tree);
+
+void startCompaction(BTree *tree);
+
+void compactStep(BTree *tree, int budget);
+
+void logCompactedWrite(BTree *tree, char command, char *date, char *description, char *end, int inclusiveEnd);
+
+void freeCompaction(Compaction *compaction);
+
+void buildTree(BTree *tree, CompactedEntry *entries, int count);
+
+#endif //BTREE_COMPACT_H
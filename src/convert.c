@@ -0,0 +1,307 @@
+#include "protocol.h"
+#include <unistd.h>
+
+#define CONVERT_BATCH 1024 // default amount of commands per frame
+
+/**
+ * Struct representing a frame that is being filled
+ */
+typedef struct Frame {
+    unsigned char *bytes; // The frame, starting with its header
+    size_t length; // The amount of bytes in the frame
+    size_t capacity; // The allocated length of bytes
+    uint32_t count; // The amount of commands in the frame
+} Frame;
+
+/**
+ * Make room for more bytes in a frame.
+ * @param frame The frame we are filling
+ * @param extra The amount of bytes we are going to add
+ * @return Pointer to where the bytes should be added
+ */
+static unsigned char *reserve(Frame *frame, size_t extra) {
+  if (frame->length + extra > frame->capacity) {
+    size_t capacity = frame->capacity > 0 ? frame->capacity : 4096;
+    while (capacity < frame->length + extra) capacity *= 2;
+    unsigned char *bytes = realloc(frame->bytes, capacity);
+    if (bytes == NULL) {
+      exit(1);
+    }
+    frame->bytes = bytes;
+    frame->capacity = capacity;
+  }
+  unsigned char *position = &frame->bytes[frame->length];
+  frame->length += extra;
+  return position;
+}
+
+/**
+ * Write a frame to stdout and empty it.
+ */
+static void flushFrame(Frame *frame) {
+  writeU32(frame->bytes, frame->length - FRAME_LENGTH);
+  writeU32(&frame->bytes[FRAME_LENGTH], frame->count);
+  fwrite(frame->bytes, 1, frame->length, stdout);
+  frame->length = FRAME_HEADER;
+  frame->count = 0;
+}
+
+/**
+ * Pack a date of a text command into a frame.
+ * @return 1 if succeeded, 0 if the text is no date
+ */
+static int addDate(Frame *frame, char *text, size_t available) {
+  uint64_t packed;
+  if (available < PACKED_DATE_LENGTH || !packDate(text, &packed)) {
+    return 0;
+  }
+  writeU64(reserve(frame, 8), packed);
+  return 1;
+}
+
+/**
+ * Convert text commands (like the tests) on stdin to frames of the binary protocol on stdout.
+ * @param batch The maximum amount of commands per frame
+ * @return the exit code of the program
+ */
+static int textToBinary(int batch) {
+  Frame frame = {NULL, 0, 0, 0};
+  reserve(&frame, FRAME_HEADER);
+
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  int status = 0;
+  while ((length = getline(&line, &capacity, stdin)) > 0) {
+    if (line[length - 1] == '\n') {
+      line[--length] = '\0';
+    }
+    if (length == 0) {
+      // An empty line ends the session, so do we
+      break;
+    }
+
+    size_t start = frame.length;
+    int valid;
+    switch (line[0]) {
+      case '+':
+        *reserve(&frame, 1) = '+';
+        valid = addDate(&frame, &line[1], length - 1) && length > PACKED_DATE_LENGTH + 1;
+        if (valid) {
+          uint32_t descriptionLength = length - PACKED_DATE_LENGTH - 2;
+          writeU32(reserve(&frame, 4), descriptionLength);
+          memcpy(reserve(&frame, descriptionLength), &line[PACKED_DATE_LENGTH + 2], descriptionLength);
+        }
+        break;
+      case '-':
+      case '?':
+      case '<':
+        *reserve(&frame, 1) = line[0];
+        valid = addDate(&frame, &line[1], length - 1);
+        break;
+      case '#':
+      case '/':
+      case '$':
+        *reserve(&frame, 1) = line[0];
+        valid = addDate(&frame, &line[1], length - 1) &&
+                length > PACKED_DATE_LENGTH + 1 &&
+                addDate(&frame, &line[PACKED_DATE_LENGTH + 2], length - PACKED_DATE_LENGTH - 2);
+        break;
+      case '%':
+      case '*':
+        *reserve(&frame, 1) = line[0];
+        valid = 1;
+        break;
+      case '@':
+        // The name of the snapshot
+        *reserve(&frame, 1) = '@';
+        valid = length > 1;
+        writeU32(reserve(&frame, 4), length - 1);
+        memcpy(reserve(&frame, length - 1), &line[1], length - 1);
+        break;
+      case '[':
+      case ']': {
+        // The amount of entries, 1 if there is none
+        char *end;
+        long count = length > 1 ? strtol(&line[1], &end, 10) : 1;
+        valid = (length == 1 || (*end == '\0' && line[1] >= '0' && line[1] <= '9')) && count <= INT32_MAX;
+        *reserve(&frame, 1) = line[0];
+        writeU32(reserve(&frame, 4), valid ? (uint32_t) count : 0);
+        break;
+      }
+      default:
+        valid = 0;
+    }
+    if (!valid) {
+      fprintf(stderr, "Can't convert the command: %s\n", line);
+      frame.length = start;
+      status = 1;
+      break;
+    }
+
+    if (++frame.count == (uint32_t) batch) {
+      flushFrame(&frame);
+    }
+  }
+  if (frame.count > 0) {
+    flushFrame(&frame);
+  }
+  free(line);
+  free(frame.bytes);
+  return status;
+}
+
+/**
+ * Read a frame of the binary protocol from stdin.
+ * @param length Set to the length of the frame, without the length in front of it
+ * @return The frame or NULL at the end of stdin
+ */
+static unsigned char *readFrame(size_t *length) {
+  unsigned char header[FRAME_LENGTH];
+  if (fread(header, 1, FRAME_LENGTH, stdin) != FRAME_LENGTH) {
+    return NULL;
+  }
+  *length = readU32(header);
+  unsigned char *frame = malloc(*length > 0 ? *length : 1);
+  if (frame == NULL) {
+    exit(1);
+  }
+  if (fread(frame, 1, *length, stdin) != *length) {
+    free(frame);
+    return NULL;
+  }
+  return frame;
+}
+
+/**
+ * Convert frames with commands on stdin back to text commands on stdout.
+ * @return the exit code of the program
+ */
+static int binaryToText() {
+  unsigned char *frame;
+  size_t length;
+  char date[PACKED_DATE_LENGTH + 1];
+  while ((frame = readFrame(&length)) != NULL) {
+    size_t offset = FRAME_HEADER - FRAME_LENGTH;
+    for (uint32_t i = 0, count = length >= offset ? readU32(frame) : 0; i < count; i++) {
+      int commandSize = commandLength(&frame[offset], length - offset);
+      if (commandSize < 0) {
+        fprintf(stderr, "Invalid frame\n");
+        free(frame);
+        return 1;
+      }
+      unsigned char *command = &frame[offset];
+      printf("%c", command[0]);
+      if (command[0] == '[' || command[0] == ']') {
+        printf("%u", readU32(&command[1]));
+      } else if (command[0] == '@') {
+        printf("%.*s", (int) readU32(&command[1]), (char *) &command[5]);
+      } else if (commandSize > 1) {
+        unpackDate(readU64(&command[1]), date);
+        printf("%s", date);
+      }
+      if (command[0] == '+') {
+        printf(" %.*s", (int) readU32(&command[9]), (char *) &command[13]);
+      } else if (command[0] == '#' || command[0] == '/' || command[0] == '$') {
+        unpackDate(readU64(&command[9]), date);
+        printf(" %s", date);
+      }
+      printf("\n");
+      offset += commandSize;
+    }
+    free(frame);
+  }
+  return 0;
+}
+
+/**
+ * Convert frames with answers on stdin to the text answers history prints.
+ * @return the exit code of the program
+ */
+static int answersToText() {
+  unsigned char *frame;
+  size_t length;
+  while ((frame = readFrame(&length)) != NULL) {
+    size_t offset = FRAME_HEADER - FRAME_LENGTH;
+    for (uint32_t i = 0, count = length >= offset ? readU32(frame) : 0; i < count && offset < length; i++) {
+      unsigned char tag = frame[offset++];
+      if (tag == '!' && offset + 4 <= length && offset + 4 + readU32(&frame[offset]) <= length) {
+        uint32_t descriptionLength = readU32(&frame[offset]);
+        printf("!%.*s\n", (int) descriptionLength, (char *) &frame[offset + 4]);
+        offset += 4 + descriptionLength;
+      } else if (tag == '[' && offset + 4 <= length) {
+        uint32_t amount = readU32(&frame[offset]);
+        offset += 4;
+        for (uint32_t j = 0; j < amount; j++) {
+          if (offset + 12 > length || offset + 12 + readU32(&frame[offset + 8]) > length) {
+            fprintf(stderr, "Invalid frame\n");
+            free(frame);
+            return 1;
+          }
+          char date[PACKED_DATE_LENGTH + 1];
+          unpackDate(readU64(&frame[offset]), date);
+          uint32_t descriptionLength = readU32(&frame[offset + 8]);
+          printf("!%s %.*s\n", date, (int) descriptionLength, (char *) &frame[offset + 12]);
+          offset += 12 + descriptionLength;
+        }
+      } else if (tag == '$' && offset + 40 <= length) {
+        printAggregate(stdout, readU32(&frame[offset]), readU64(&frame[offset + 4]), readU32(&frame[offset + 12]),
+                       readF64(&frame[offset + 16]), readF64(&frame[offset + 24]), readF64(&frame[offset + 32]));
+        offset += 40;
+      } else if (tag == '#' && offset + 4 <= length) {
+        printf("%i\n", (int) readU32(&frame[offset]));
+        offset += 4;
+      } else if (tag == '?' || tag == '-') {
+        printf("%c\n", tag);
+      } else {
+        fprintf(stderr, "Invalid frame\n");
+        free(frame);
+        return 1;
+      }
+    }
+    free(frame);
+  }
+  return 0;
+}
+
+/**
+ * Converter between the text commands and answers (like the files in tests/) and the binary protocol of history.
+ * Options:
+ *  -b  text commands to frames (the default), -n count: commands per frame
+ *  -t  frames with commands to text commands
+ *  -a  frames with answers to text answers
+ * @param argc
+ * @param argv
+ * @return the exit code of the program
+ */
+int main(int argc, char *argv[]) {
+  int mode = 'b';
+  int batch = CONVERT_BATCH;
+
+  int option;
+  while ((option = getopt(argc, argv, "btan:")) != -1) {
+    switch (option) {
+      case 'b':
+      case 't':
+      case 'a':
+        mode = option;
+        break;
+      case 'n':
+        batch = atoi(optarg);
+        if (batch > 0) break;
+        // fall through
+      default:
+        fprintf(stderr, "Usage: %s [-b [-n count] | -t | -a] < input > output\n", argv[0]);
+        return 1;
+    }
+  }
+
+  switch (mode) {
+    case 't':
+      return binaryToText();
+    case 'a':
+      return answersToText();
+    default:
+      return textToBinary(batch);
+  }
+}
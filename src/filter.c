@@ -0,0 +1,231 @@
+#include "filter.h"
+#include "buffer.h"
+
+/**
+ * Create an empty filter.
+ * @param bucketCount The amount of buckets, a power of two
+ * @return The created filter or NULL if we are out of memory
+ */
+Filter *createFilter(uint32_t bucketCount) {
+  Filter *filter = malloc(sizeof(Filter));
+  if (filter == NULL) {
+    return NULL;
+  }
+  filter->fingerprints = calloc((size_t) bucketCount * FILTER_SLOTS, sizeof(uint16_t));
+  if (filter->fingerprints == NULL) {
+    free(filter);
+    return NULL;
+  }
+  filter->bucketCount = bucketCount;
+  filter->count = 0;
+  filter->victim = 1;
+  return filter;
+}
+
+/**
+ * Free a filter.
+ * @param filter The filter we want to free, may be NULL
+ */
+void freeFilter(Filter *filter) {
+  if (filter == NULL) {
+    return;
+  }
+  free(filter->fingerprints);
+  free(filter);
+}
+
+/**
+ * Hash a key (FNV-1a), the filter takes its fingerprint and both buckets from this hash.
+ * @param date The key we are hashing
+ * @return The hash of the key
+ */
+uint64_t hashKey(char *date) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < DATE && date[i] != '\0'; i++) {
+    hash ^= (unsigned char) date[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * The fingerprint of a hash, never 0 since that marks an empty slot.
+ */
+static uint16_t fingerprintOf(uint64_t hash) {
+  uint16_t fingerprint = (uint16_t) (hash >> 48);
+  return fingerprint != 0 ? fingerprint : 1;
+}
+
+/**
+ * The other bucket a fingerprint can be in, only depends on the fingerprint so we can move it without the key.
+ */
+static uint32_t alternateBucket(Filter *filter, uint32_t bucket, uint16_t fingerprint) {
+  return (bucket ^ (fingerprint * 0x5bd1e995U)) & (filter->bucketCount - 1);
+}
+
+/**
+ * Put a fingerprint in an empty slot of a bucket.
+ * @return 1 if there was an empty slot, 0 otherwise
+ */
+static int putInBucket(Filter *filter, uint32_t bucket, uint16_t fingerprint) {
+  uint16_t *slots = &filter->fingerprints[bucket * FILTER_SLOTS];
+  for (int i = 0; i < FILTER_SLOTS; i++) {
+    if (slots[i] == 0) {
+      slots[i] = fingerprint;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Add a key to the filter. If both of its buckets are full, fingerprints are relocated to their other bucket.
+ * @param filter The filter we are adding to
+ * @param hash The hash of the key
+ * @return 1 if succeeded, 0 if the filter is full. A fingerprint is lost then, so the filter should be rebuilt.
+ */
+int filterAdd(Filter *filter, uint64_t hash) {
+  uint16_t fingerprint = fingerprintOf(hash);
+  uint32_t bucket = (uint32_t) hash & (filter->bucketCount - 1);
+  filter->count++;
+  if (putInBucket(filter, bucket, fingerprint) ||
+      putInBucket(filter, alternateBucket(filter, bucket, fingerprint), fingerprint)) {
+    return 1;
+  }
+
+  for (int kick = 0; kick < FILTER_KICKS; kick++) {
+    // xorshift, the relocated slot has to vary or we keep swapping the same two fingerprints
+    filter->victim ^= filter->victim << 13;
+    filter->victim ^= filter->victim >> 17;
+    filter->victim ^= filter->victim << 5;
+    uint16_t *slot = &filter->fingerprints[bucket * FILTER_SLOTS + filter->victim % FILTER_SLOTS];
+    uint16_t evicted = *slot;
+    *slot = fingerprint;
+    fingerprint = evicted;
+    bucket = alternateBucket(filter, bucket, fingerprint);
+    if (putInBucket(filter, bucket, fingerprint)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Check if a key might be in the filter.
+ * @param filter The filter we are searching in
+ * @param hash The hash of the key
+ * @return 0 if the key is surely not in the filter, 1 if it might be
+ */
+int filterContains(Filter *filter, uint64_t hash) {
+  uint16_t fingerprint = fingerprintOf(hash);
+  uint32_t first = (uint32_t) hash & (filter->bucketCount - 1);
+  uint32_t second = alternateBucket(filter, first, fingerprint);
+  for (int i = 0; i < FILTER_SLOTS; i++) {
+    if (filter->fingerprints[first * FILTER_SLOTS + i] == fingerprint ||
+        filter->fingerprints[second * FILTER_SLOTS + i] == fingerprint) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Remove one copy of a key from the filter. Only keys that were added may be removed, otherwise we could remove the
+ * fingerprint of another key.
+ * @param filter The filter we are removing from
+ * @param hash The hash of the key
+ */
+void filterRemove(Filter *filter, uint64_t hash) {
+  uint16_t fingerprint = fingerprintOf(hash);
+  uint32_t first = (uint32_t) hash & (filter->bucketCount - 1);
+  uint32_t buckets[2] = {first, alternateBucket(filter, first, fingerprint)};
+  for (int b = 0; b < 2; b++) {
+    uint16_t *slots = &filter->fingerprints[buckets[b] * FILTER_SLOTS];
+    for (int i = 0; i < FILTER_SLOTS; i++) {
+      if (slots[i] == fingerprint) {
+        slots[i] = 0;
+        filter->count--;
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Add all live keys in and underneath a node to a filter.
+ * @return 1 if succeeded, 0 if the filter got full
+ */
+static int addNodeToFilter(Filter *filter, BTreeNode *node) {
+  for (int i = 0; i <= node->size; i++) {
+    if (!node->leaf && !addNodeToFilter(filter, node->childNodes[i])) {
+      return 0;
+    }
+    if (i < node->size && node->descriptionValues[i] != NULL && !filterAdd(filter, hashKey(node->dateKeys[i]))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Turn on the negative-lookup filter of a tree, it is filled with the entries that are already in the tree.
+ * @param tree The tree that should get a filter
+ */
+void enableFilter(BTree *tree) {
+  if (tree->filter == NULL) {
+    rebuildFilter(tree);
+  }
+}
+
+/**
+ * Replace the filter of a tree by a new one, sized for the live entries of the tree (at most half full) and without
+ * stale fingerprints. Buffered writes are applied first, so all live keys are in the nodes.
+ * @param tree The tree whose filter we are rebuilding
+ */
+void rebuildFilter(BTree *tree) {
+  if (tree->buffered) {
+    flushRange(tree, NULL, NULL);
+  }
+  uint32_t bucketCount = FILTER_MIN_BUCKETS;
+  while (bucketCount * FILTER_SLOTS < 2U * tree->root->recursiveSize) {
+    bucketCount *= 2;
+  }
+
+  while (1) {
+    Filter *filter = createFilter(bucketCount);
+    if (filter == NULL) {
+      freeBTree(tree);
+      exit(1);
+    }
+    if (addNodeToFilter(filter, tree->root)) {
+      freeFilter(tree->filter);
+      tree->filter = filter;
+      return;
+    }
+    freeFilter(filter);
+    bucketCount *= 2;
+  }
+}
+
+/**
+ * Add a key that (might have) become live to the filter of a tree, the filter is rebuilt when it is full.
+ * @param tree The tree the key was inserted in
+ * @param hash The hash of the key
+ */
+void filterInserted(BTree *tree, uint64_t hash) {
+  if (!filterAdd(tree->filter, hash)) {
+    rebuildFilter(tree);
+  }
+}
+
+/**
+ * Rebuild the filter of a tree if most of its fingerprints are stale, after keys were removed without taking their
+ * fingerprint out (range removals).
+ * @param tree The tree whose filter we are checking
+ */
+void syncFilter(BTree *tree) {
+  int stale = tree->filter->count - tree->root->recursiveSize;
+  if (stale > tree->root->recursiveSize && stale > FILTER_MIN_BUCKETS) {
+    rebuildFilter(tree);
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef BTREE_FILTER_H
+#define BTREE_FILTER_H
+
+#include "btree.h"
+#include <stdint.h>
+
+#define FILTER_SLOTS 4 // amount of fingerprints in one bucket of the filter
+#ifndef FILTER_MIN_BUCKETS
+#define FILTER_MIN_BUCKETS 64 // the filter never gets less buckets than this, must be a power of two
+#endif
+#define FILTER_KICKS 500 // amount of fingerprints we relocate before we call the filter full
+
+/**
+ * Struct representing a cuckoo filter over the keys of a tree, answering most lookups of absent keys without
+ * descending the tree. A key can be in the filter more than once, every copy only costs false positives.
+ */
+struct Filter {
+    uint16_t *fingerprints; // FILTER_SLOTS fingerprints per bucket, 0 marks an empty slot
+    uint32_t bucketCount; // The amount of buckets, a power of two
+    int count; // The amount of fingerprints in the filter
+    uint32_t victim; // State of the generator choosing which fingerprint we relocate
+};
+
+/*
+ * Functions for the creation and free-ing of filters
+ */
+Filter *createFilter(uint32_t bucketCount);
+
+void freeFilter(Filter *filter);
+
+/*
+ * Functions on the filter itself, on the hash of a key
+ */
+uint64_t hashKey(char *date);
+
+int filterAdd(Filter *filter, uint64_t hash);
+
+int filterContains(Filter *filter, uint64_t hash);
+
+void filterRemove(Filter *filter, uint64_t hash);
+
+/*
+ * Functions keeping the filter of a tree in sync with its live entries
+ */
+void enableFilter(BTree *tree);
+
+void rebuildFilter(BTree *tree);
+
+void filterInserted(BTree *tree, uint64_t hash);
+
+void syncFilter(BTree *tree);
+
+#endif //BTREE_FILTER_H
@@ -0,0 +1,91 @@
+#include "gentrees.h"
+#include "protocol.h"
+
+/**
+ * Copy a piece of a command line into a string of its own.
+ * @param text The start of the piece
+ * @param length The amount of characters of the piece
+ * @return The string, the caller should free it
+ */
+static char *copyText(const char *text, size_t length) {
+  char *copy = malloc(sizeof(char) * (length + 1));
+  if (copy == NULL) {
+    exit(1);
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+/**
+ * Run the +, -, ? and # commands on stdin on a NanoTree keyed on the packed dates (see protocol.h) and print the
+ * answers like history does.
+ * @return the exit code of the program
+ */
+static int runCommands(void) {
+  NanoTree *nanos = nanoTreeCreate();
+
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  int status = 0;
+  while ((length = getline(&line, &capacity, stdin)) > 0) {
+    if (line[length - 1] == '\n') {
+      line[--length] = '\0';
+    }
+    if (length == 0) {
+      // An empty line ends the session
+      break;
+    }
+
+    // "+DATE description", "-DATE", "?DATE" or "#DATE DATE"
+    char command = line[0];
+    ssize_t needed = command == '#' ? 2 * PACKED_DATE_LENGTH + 2 :
+                     command == '+' ? PACKED_DATE_LENGTH + 2 : PACKED_DATE_LENGTH + 1;
+    uint64_t key;
+    uint64_t end = 0;
+    if ((command != '+' && command != '-' && command != '?' && command != '#') || length < needed ||
+        !packDate(&line[1], &key) || (command == '#' && !packDate(&line[PACKED_DATE_LENGTH + 2], &end))) {
+      printf("This is an invalid command. The program will now exit");
+      status = 1;
+      break;
+    }
+    if (command == '#' && key > end) {
+      // Packed dates compare like the ISO dates
+      uint64_t swap = key;
+      key = end;
+      end = swap;
+    }
+
+    if (command == '+') {
+      char *description = copyText(&line[PACKED_DATE_LENGTH + 2], length - PACKED_DATE_LENGTH - 2);
+      if (!nanoTreeInsert(nanos, key, description)) {
+        free(description);
+      }
+    } else if (command == '-') {
+      printf(nanoTreeRemove(nanos, key) ? "-\n" : "?\n");
+    } else if (command == '?') {
+      char **description = nanoTreeGet(nanos, key);
+      if (description != NULL) {
+        printf("!%s\n", *description);
+      } else {
+        printf("?\n");
+      }
+    } else {
+      printf("%i\n", nanoTreeCount(nanos, key, end));
+    }
+  }
+
+  free(line);
+  nanoTreeFree(nanos);
+  return status;
+}
+
+/**
+ * history on the NanoTree of gentrees.h, for the tests and benchmarks of the generic tree. Only knows the +, -, ? and
+ * # commands.
+ * @return the exit code of the program
+ */
+int main(void) {
+  return runCommands();
+}
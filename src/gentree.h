@@ -0,0 +1,378 @@
+/*
+ * A BTree with the key type, comparator, value type and node order as compile-time parameters. This header is a
+ * template: define the parameters below and include it, once per instantiation. Without GENTREE_IMPLEMENTATION only
+ * the types and declarations are generated, with it the functions as well (in one translation unit).
+ *
+ *  GENTREE_TYPE            name of the tree type, the node type is GENTREE_TYPE##Node
+ *  GENTREE_PREFIX          prefix of the functions, e.g. nanoTree gives nanoTreeInsert
+ *  GENTREE_KEY             the key type, stored in the nodes
+ *  GENTREE_VALUE           the value type, stored in the nodes
+ *  GENTREE_ORDER           maximum amount of keys in a node, at least 3
+ *  GENTREE_COMPARE(a, b)   < 0, 0 or > 0 like strcmp
+ *  GENTREE_FREE_KEY(k)     frees a key the tree owns (optional)
+ *  GENTREE_FREE_VALUE(v)   frees a value the tree owns (optional)
+ *
+ * Like the BTree of btree.c, removed entries stay behind as gravestones and every node counts the live entries in and
+ * underneath it, so counts between two keys only descend twice. Inserting a key that is live already keeps the old
+ * value. Full nodes are split on the way down, so no node needs a pointer to its parent.
+ *
+ * Only the core of the BTree is generic: history keeps the string tree of btree.c, whose message buffers, filters,
+ * aggregates, compactions and shards are built on its nodes and aren't part of this template.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef GENTREE_FREE_KEY
+#define GENTREE_FREE_KEY(key)
+#endif
+#ifndef GENTREE_FREE_VALUE
+#define GENTREE_FREE_VALUE(value)
+#endif
+
+#define GENTREE_JOIN2(a, b) a##b
+#define GENTREE_JOIN(a, b) GENTREE_JOIN2(a, b)
+#define GT_NODE GENTREE_JOIN(GENTREE_TYPE, Node)
+#define GT_FUNCTION(name) GENTREE_JOIN(GENTREE_PREFIX, name)
+
+typedef struct GT_NODE GT_NODE;
+
+/**
+ * Struct representing a node of the tree
+ */
+struct GT_NODE {
+    int size; // amount of entries in the node
+    int live; // amount of live entries in and underneath the node
+    int leaf; // leaf: 1, not a leaf: 0
+    GENTREE_KEY keys[GENTREE_ORDER]; // The keys of the entries
+    GENTREE_VALUE values[GENTREE_ORDER]; // The values of the entries
+    unsigned char alive[GENTREE_ORDER]; // 1 for a live entry, 0 for a gravestone
+    GT_NODE *children[GENTREE_ORDER + 1]; // The children, NULL in a leaf
+};
+
+/**
+ * Struct representing the tree
+ */
+typedef struct GENTREE_TYPE {
+    GT_NODE *root; // The root, a leaf as long as the tree is small
+} GENTREE_TYPE;
+
+/*
+ * Functions for the creation and free-ing of the tree
+ */
+GENTREE_TYPE *GT_FUNCTION(Create)(void);
+
+void GT_FUNCTION(Free)(GENTREE_TYPE *tree);
+
+/*
+ * Functions for the entries of the tree
+ */
+int GT_FUNCTION(Insert)(GENTREE_TYPE *tree, GENTREE_KEY key, GENTREE_VALUE value);
+
+GENTREE_VALUE *GT_FUNCTION(Get)(GENTREE_TYPE *tree, GENTREE_KEY key);
+
+int GT_FUNCTION(Remove)(GENTREE_TYPE *tree, GENTREE_KEY key);
+
+int GT_FUNCTION(Count)(GENTREE_TYPE *tree, GENTREE_KEY begin, GENTREE_KEY end);
+
+int GT_FUNCTION(Size)(GENTREE_TYPE *tree);
+
+#ifdef GENTREE_IMPLEMENTATION
+
+/**
+ * Create an empty node.
+ * @param leaf 1 for a leaf, 0 otherwise
+ * @return The node
+ */
+static GT_NODE *GT_FUNCTION(CreateNode)(int leaf) {
+  GT_NODE *node = malloc(sizeof(GT_NODE));
+  if (node == NULL) {
+    exit(1);
+  }
+  node->size = 0;
+  node->live = 0;
+  node->leaf = leaf;
+  return node;
+}
+
+/**
+ * Create an empty tree.
+ * @return The tree
+ */
+GENTREE_TYPE *GT_FUNCTION(Create)(void) {
+  GENTREE_TYPE *tree = malloc(sizeof(GENTREE_TYPE));
+  if (tree == NULL) {
+    exit(1);
+  }
+  tree->root = GT_FUNCTION(CreateNode)(1);
+  return tree;
+}
+
+/**
+ * Free a node, everything underneath it and the keys and live values it owns.
+ */
+static void GT_FUNCTION(FreeNode)(GT_NODE *node) {
+  for (int i = 0; i < node->size; i++) {
+    GENTREE_FREE_KEY(node->keys[i]);
+    if (node->alive[i]) {
+      GENTREE_FREE_VALUE(node->values[i]);
+    }
+  }
+  if (!node->leaf) {
+    for (int i = 0; i <= node->size; i++) {
+      GT_FUNCTION(FreeNode)(node->children[i]);
+    }
+  }
+  free(node);
+}
+
+/**
+ * Free the tree and all of its entries.
+ * @param tree The tree we want to free
+ */
+void GT_FUNCTION(Free)(GENTREE_TYPE *tree) {
+  GT_FUNCTION(FreeNode)(tree->root);
+  free(tree);
+}
+
+/**
+ * The amount of keys in a node that are smaller than (or equal to) a key.
+ * @param inclusive 1 to count the key equal to search as well, 0 otherwise
+ */
+static int GT_FUNCTION(Rank)(GT_NODE *node, GENTREE_KEY search, int inclusive) {
+  int low = 0;
+  int high = node->size;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    int cmp = GENTREE_COMPARE(node->keys[middle], search);
+    if (cmp < 0 || (inclusive && cmp == 0)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * Find the node and index of a key.
+ * @param index Set to the index of the key in the node
+ * @return The node or NULL if the key is not in the tree (not even as gravestone)
+ */
+static GT_NODE *GT_FUNCTION(Find)(GENTREE_TYPE *tree, GENTREE_KEY key, int *index) {
+  GT_NODE *node = tree->root;
+  while (1) {
+    int i = GT_FUNCTION(Rank)(node, key, 0);
+    if (i < node->size && GENTREE_COMPARE(node->keys[i], key) == 0) {
+      *index = i;
+      return node;
+    }
+    if (node->leaf) {
+      return NULL;
+    }
+    node = node->children[i];
+  }
+}
+
+/**
+ * Add to the live counts of the nodes on the path from the root to a key that is in the tree.
+ */
+static void GT_FUNCTION(UpdateLive)(GENTREE_TYPE *tree, GENTREE_KEY key, int update) {
+  GT_NODE *node = tree->root;
+  while (1) {
+    node->live += update;
+    int i = GT_FUNCTION(Rank)(node, key, 0);
+    if (i < node->size && GENTREE_COMPARE(node->keys[i], key) == 0) {
+      return;
+    }
+    node = node->children[i];
+  }
+}
+
+/**
+ * Recalculate the live count of a node out of its entries and children.
+ */
+static void GT_FUNCTION(Recount)(GT_NODE *node) {
+  node->live = 0;
+  for (int i = 0; i < node->size; i++) {
+    node->live += node->alive[i];
+  }
+  if (!node->leaf) {
+    for (int i = 0; i <= node->size; i++) {
+      node->live += node->children[i]->live;
+    }
+  }
+}
+
+/**
+ * Split a full child of a node in two, its middle entry moves up into the node.
+ * @param parent The node, not full
+ * @param index The index of the full child in parent
+ */
+static void GT_FUNCTION(SplitChild)(GT_NODE *parent, int index) {
+  GT_NODE *left = parent->children[index];
+  GT_NODE *right = GT_FUNCTION(CreateNode)(left->leaf);
+  int middle = GENTREE_ORDER / 2;
+  int moved = left->size - middle - 1;
+  memcpy(right->keys, &left->keys[middle + 1], sizeof(GENTREE_KEY) * moved);
+  memcpy(right->values, &left->values[middle + 1], sizeof(GENTREE_VALUE) * moved);
+  memcpy(right->alive, &left->alive[middle + 1], moved);
+  if (!left->leaf) {
+    memcpy(right->children, &left->children[middle + 1], sizeof(GT_NODE *) * (moved + 1));
+  }
+  right->size = moved;
+  left->size = middle;
+
+  int after = parent->size - index;
+  memmove(&parent->keys[index + 1], &parent->keys[index], sizeof(GENTREE_KEY) * after);
+  memmove(&parent->values[index + 1], &parent->values[index], sizeof(GENTREE_VALUE) * after);
+  memmove(&parent->alive[index + 1], &parent->alive[index], after);
+  memmove(&parent->children[index + 2], &parent->children[index + 1], sizeof(GT_NODE *) * after);
+  parent->keys[index] = left->keys[middle];
+  parent->values[index] = left->values[middle];
+  parent->alive[index] = left->alive[middle];
+  parent->children[index + 1] = right;
+  parent->size++;
+
+  GT_FUNCTION(Recount)(left);
+  GT_FUNCTION(Recount)(right);
+}
+
+/**
+ * Insert an entry. A gravestone on the key comes back to life, a live key keeps its value.
+ * @param tree The tree where we want to add an entry
+ * @param key The key, the tree owns it if the entry is added
+ * @param value The value, the tree owns it if the entry is added or comes back to life
+ * @return 1 if a new entry was added, 2 if a gravestone came back to life, 0 if the key was live already
+ */
+int GT_FUNCTION(Insert)(GENTREE_TYPE *tree, GENTREE_KEY key, GENTREE_VALUE value) {
+  int index;
+  GT_NODE *found = GT_FUNCTION(Find)(tree, key, &index);
+  if (found != NULL) {
+    if (found->alive[index]) {
+      return 0;
+    }
+    found->values[index] = value;
+    found->alive[index] = 1;
+    GT_FUNCTION(UpdateLive)(tree, key, +1);
+    return 2;
+  }
+
+  if (tree->root->size == GENTREE_ORDER) {
+    GT_NODE *root = GT_FUNCTION(CreateNode)(0);
+    root->children[0] = tree->root;
+    GT_FUNCTION(SplitChild)(root, 0);
+    tree->root = root;
+    GT_FUNCTION(Recount)(root);
+  }
+
+  // The key is new, so every node on the way down gets one more live entry
+  GT_NODE *node = tree->root;
+  while (!node->leaf) {
+    node->live++;
+    int i = GT_FUNCTION(Rank)(node, key, 0);
+    if (node->children[i]->size == GENTREE_ORDER) {
+      GT_FUNCTION(SplitChild)(node, i);
+      if (GENTREE_COMPARE(node->keys[i], key) < 0) {
+        i++;
+      }
+    }
+    node = node->children[i];
+  }
+  int i = GT_FUNCTION(Rank)(node, key, 0);
+  int after = node->size - i;
+  memmove(&node->keys[i + 1], &node->keys[i], sizeof(GENTREE_KEY) * after);
+  memmove(&node->values[i + 1], &node->values[i], sizeof(GENTREE_VALUE) * after);
+  memmove(&node->alive[i + 1], &node->alive[i], after);
+  node->keys[i] = key;
+  node->values[i] = value;
+  node->alive[i] = 1;
+  node->size++;
+  node->live++;
+  return 1;
+}
+
+/**
+ * Find the value of a live entry.
+ * @param tree The tree we are searching in
+ * @param key The key we are searching
+ * @return Pointer to the value in the tree, NULL if the key is not live
+ */
+GENTREE_VALUE *GT_FUNCTION(Get)(GENTREE_TYPE *tree, GENTREE_KEY key) {
+  int index;
+  GT_NODE *found = GT_FUNCTION(Find)(tree, key, &index);
+  return found != NULL && found->alive[index] ? &found->values[index] : NULL;
+}
+
+/**
+ * Remove an entry, its key stays behind as a gravestone.
+ * @param tree The tree where we want to remove an entry
+ * @param key The key of the entry
+ * @return 1 if the entry was live, 0 otherwise
+ */
+int GT_FUNCTION(Remove)(GENTREE_TYPE *tree, GENTREE_KEY key) {
+  int index;
+  GT_NODE *found = GT_FUNCTION(Find)(tree, key, &index);
+  if (found == NULL || !found->alive[index]) {
+    return 0;
+  }
+  GENTREE_FREE_VALUE(found->values[index]);
+  found->alive[index] = 0;
+  GT_FUNCTION(UpdateLive)(tree, key, -1);
+  return 1;
+}
+
+/**
+ * The amount of live entries with a key smaller than (or equal to) a key.
+ * @param inclusive 1 to count the entry on key as well, 0 otherwise
+ */
+static int GT_FUNCTION(LiveBefore)(GENTREE_TYPE *tree, GENTREE_KEY key, int inclusive) {
+  int count = 0;
+  GT_NODE *node = tree->root;
+  while (1) {
+    int i = GT_FUNCTION(Rank)(node, key, inclusive);
+    for (int j = 0; j < i; j++) {
+      count += node->alive[j];
+      if (!node->leaf) {
+        count += node->children[j]->live;
+      }
+    }
+    if (node->leaf) {
+      return count;
+    }
+    node = node->children[i];
+  }
+}
+
+/**
+ * Count the live entries between two keys, both inclusive.
+ * @param tree The tree we are counting in
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The amount of live entries
+ */
+int GT_FUNCTION(Count)(GENTREE_TYPE *tree, GENTREE_KEY begin, GENTREE_KEY end) {
+  if (GENTREE_COMPARE(begin, end) > 0) {
+    return 0;
+  }
+  return GT_FUNCTION(LiveBefore)(tree, end, 1) - GT_FUNCTION(LiveBefore)(tree, begin, 0);
+}
+
+/**
+ * The amount of live entries in the tree.
+ */
+int GT_FUNCTION(Size)(GENTREE_TYPE *tree) {
+  return tree->root->live;
+}
+
+#endif //GENTREE_IMPLEMENTATION
+
+#undef GT_NODE
+#undef GT_FUNCTION
+#undef GENTREE_TYPE
+#undef GENTREE_PREFIX
+#undef GENTREE_KEY
+#undef GENTREE_VALUE
+#undef GENTREE_ORDER
+#undef GENTREE_COMPARE
+#undef GENTREE_FREE_KEY
+#undef GENTREE_FREE_VALUE
@@ -0,0 +1,2 @@
+#define GENTREE_IMPLEMENTATION
+#include "gentrees.h"
@@ -0,0 +1,23 @@
+#ifndef BTREE_GENTREES_H
+#define BTREE_GENTREES_H
+
+#include <stdint.h>
+
+#ifndef NANOTREE_ORDER
+#define NANOTREE_ORDER 127 // keys per node of a NanoTree, 8 bytes each
+#endif
+
+/*
+ * NanoTree: keys are packed u64 epoch nanoseconds, compared as integers and stored in the nodes themselves. Values
+ * are descriptions, freed by the tree.
+ */
+#define GENTREE_TYPE NanoTree
+#define GENTREE_PREFIX nanoTree
+#define GENTREE_KEY uint64_t
+#define GENTREE_VALUE char *
+#define GENTREE_ORDER NANOTREE_ORDER
+#define GENTREE_COMPARE(a, b) (((a) > (b)) - ((a) < (b)))
+#define GENTREE_FREE_VALUE(value) free(value)
+#include "gentree.h"
+
+#endif //BTREE_GENTREES_H
@@ -0,0 +1,712 @@
+#include "hybrid.h"
+#include "aggregate.h"
+#include "protocol.h"
+
+/**
+ * Struct representing the live entries of the frozen delta, packed for the merge
+ */
+typedef struct FrozenEntries {
+    uint64_t *keys; // The packed keys, sorted
+    char **descriptions; // The descriptions of the keys
+    int size; // The amount of entries
+} FrozenEntries;
+
+/**
+ * Struct representing the entries at an edge of one part of the engine, in the order they are visited
+ */
+typedef struct EdgeList {
+    char (*dates)[DATE]; // Copies of the keys
+    char **descriptions; // The descriptions of the keys
+    int size; // The amount of entries
+    int capacity; // The allocated length of dates and descriptions
+    BTree *shadow; // Entries in this tree are skipped, NULL to skip none
+} EdgeList;
+
+/**
+ * Create a BTree whose entries are kept in a static index and a delta.
+ * @return A created BTree or NULL if we are out of memory
+ */
+BTree *createHybridBTree() {
+  BTree *tree = (BTree *) malloc(sizeof(BTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->size = 0;
+  tree->root = NULL;
+  tree->shards = NULL;
+  tree->detached.nodes = NULL;
+  tree->detached.size = 0;
+  tree->detached.capacity = 0;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->buffered = 0;
+  tree->filter = NULL;
+  tree->bplus = NULL;
+  tree->paged = NULL;
+  tree->compaction = NULL;
+  tree->compactBelow = 0;
+  tree->compactCheck = 0;
+  tree->snapshotDirectory = NULL;
+  tree->hybrid = createHybrid();
+  if (tree->hybrid == NULL) {
+    free(tree);
+    return NULL;
+  }
+  return tree;
+}
+
+/**
+ * Create a hybrid engine with an empty index and an empty delta.
+ * @return The created engine or NULL if we are out of memory
+ */
+Hybrid *createHybrid() {
+  Hybrid *hybrid = calloc(1, sizeof(Hybrid));
+  if (hybrid == NULL) {
+    return NULL;
+  }
+  hybrid->index = createStaticIndex(NULL, NULL, 0);
+  hybrid->delta = createBTree();
+  if (hybrid->index == NULL || hybrid->delta == NULL) {
+    if (hybrid->index != NULL) {
+      freeStaticIndex(hybrid->index, 1);
+    }
+    if (hybrid->delta != NULL) {
+      freeBTree(hybrid->delta);
+    }
+    free(hybrid);
+    return NULL;
+  }
+  return hybrid;
+}
+
+/**
+ * Fill an empty hybrid engine with sorted entries at once. The entries whose key is a date become the static index
+ * straight away, the others go into the delta.
+ * @param hybrid The engine, still empty
+ * @param entries The live entries in strictly increasing order, the engine owns the strings afterwards
+ * @param count The amount of entries
+ */
+void buildHybrid(Hybrid *hybrid, CompactedEntry *entries, int count) {
+  uint64_t *keys = malloc(sizeof(uint64_t) * (count + 1));
+  char **descriptions = malloc(sizeof(char *) * (count + 1));
+  if (keys == NULL || descriptions == NULL) {
+    exit(1);
+  }
+  int size = 0;
+  for (int i = 0; i < count; i++) {
+    if (packDate(entries[i].date, &keys[size])) {
+      // Packed dates compare like the dates, so the keys stay sorted
+      descriptions[size++] = entries[i].description;
+      free(entries[i].date);
+    } else {
+      insertEntry(hybrid->delta, entries[i].date, entries[i].description);
+    }
+  }
+  free(entries);
+
+  StaticIndex *index = createStaticIndex(keys, descriptions, size);
+  if (index == NULL) {
+    exit(1);
+  }
+  freeStaticIndex(hybrid->index, 1);
+  hybrid->index = index;
+}
+
+/**
+ * Copy a key, for a tree that takes it over.
+ */
+static char *copyKey(char *date) {
+  char *copy = malloc(sizeof(char) * DATE);
+  if (copy == NULL) {
+    exit(1);
+  }
+  memcpy(copy, date, DATE);
+  return copy;
+}
+
+/**
+ * Collect the live entries of a subtree of the frozen delta in order.
+ * @param hybrid The engine that is merging, the entries whose key is not a date are added to its unpacked
+ * @param node The root of the subtree
+ * @param entries The entries we add the packed ones to
+ */
+static void collectFrozen(Hybrid *hybrid, BTreeNode *node, FrozenEntries *entries) {
+  for (int i = 0; i <= node->size; i++) {
+    if (!node->leaf) {
+      collectFrozen(hybrid, node->childNodes[i], entries);
+    }
+    if (i == node->size || node->descriptionValues[i] == NULL) {
+      continue;
+    }
+    if (packDate(node->dateKeys[i], &entries->keys[entries->size])) {
+      entries->descriptions[entries->size++] = node->descriptionValues[i];
+    } else {
+      hybrid->unpacked[hybrid->unpackedCount].date = node->dateKeys[i];
+      hybrid->unpacked[hybrid->unpackedCount++].description = node->descriptionValues[i];
+    }
+  }
+}
+
+/**
+ * Build the merged index out of the live entries of the index and the frozen delta. This runs on the merger thread,
+ * the main thread only reads the index and the frozen delta in the meantime.
+ * @param argument The engine that is merging
+ * @return NULL
+ */
+static void *mergeIndex(void *argument) {
+  Hybrid *hybrid = argument;
+  StaticIndex *index = hybrid->index;
+  int frozenSize = hybrid->frozen->root->recursiveSize;
+
+  FrozenEntries frozen;
+  frozen.keys = malloc(sizeof(uint64_t) * (frozenSize + 1));
+  frozen.descriptions = malloc(sizeof(char *) * (frozenSize + 1));
+  frozen.size = 0;
+  hybrid->unpacked = malloc(sizeof(HybridEntry) * (frozenSize + 1));
+  hybrid->unpackedCount = 0;
+  int capacity = index->size - index->removedCount + frozenSize;
+  uint64_t *keys = malloc(sizeof(uint64_t) * (capacity + 1));
+  char **descriptions = malloc(sizeof(char *) * (capacity + 1));
+  if (frozen.keys == NULL || frozen.descriptions == NULL || hybrid->unpacked == NULL || keys == NULL ||
+      descriptions == NULL) {
+    exit(1);
+  }
+  collectFrozen(hybrid, hybrid->frozen->root, &frozen);
+
+  // A key is never live in both, so this is a plain merge of two sorted lists
+  int size = 0;
+  int next = 0;
+  for (int i = 0; i < index->size; i++) {
+    if (!staticIsLive(index, i)) {
+      continue;
+    }
+    while (next < frozen.size && frozen.keys[next] < index->keys[i]) {
+      keys[size] = frozen.keys[next];
+      descriptions[size++] = frozen.descriptions[next++];
+    }
+    keys[size] = index->keys[i];
+    descriptions[size++] = index->descriptions[i];
+  }
+  for (; next < frozen.size; next++) {
+    keys[size] = frozen.keys[next];
+    descriptions[size++] = frozen.descriptions[next];
+  }
+  free(frozen.keys);
+  free(frozen.descriptions);
+
+  hybrid->merged = createStaticIndex(keys, descriptions, size);
+  if (hybrid->merged == NULL) {
+    exit(1);
+  }
+  __atomic_store_n(&hybrid->finished, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/**
+ * Start merging the delta into the index on the merger thread, a new delta takes the writes.
+ * @param hybrid The engine we want to merge
+ */
+static void startMerge(Hybrid *hybrid) {
+  hybrid->frozen = hybrid->delta;
+  hybrid->delta = createBTree();
+  hybrid->shadow = createBTree();
+  if (hybrid->delta == NULL || hybrid->shadow == NULL) {
+    exit(1);
+  }
+  hybrid->finished = 0;
+  hybrid->merging = 1;
+  if (pthread_create(&hybrid->merger, NULL, mergeIndex, hybrid) != 0) {
+    // No thread, we merge right away
+    mergeIndex(hybrid);
+    hybrid->merging = 0;
+  }
+}
+
+/**
+ * Remove the entries of the shadow tree from the merged index.
+ */
+static void applyShadow(StaticIndex *index, BTreeNode *node) {
+  for (int i = 0; i <= node->size; i++) {
+    if (!node->leaf) {
+      applyShadow(index, node->childNodes[i]);
+    }
+    if (i < node->size && node->descriptionValues[i] != NULL) {
+      int position = staticFind(index, node->dateKeys[i]);
+      if (position >= 0) {
+        staticRemove(index, position);
+      }
+    }
+  }
+}
+
+/**
+ * Forget the descriptions of a subtree of the frozen delta, they were handed over to the merged index.
+ */
+static void releaseDescriptions(BTreeNode *node) {
+  for (int i = 0; i <= node->size; i++) {
+    if (!node->leaf) {
+      releaseDescriptions(node->childNodes[i]);
+    }
+    if (i < node->size) {
+      node->descriptionValues[i] = NULL;
+    }
+  }
+}
+
+/**
+ * Replace the index by the merged one, once the merger thread is done.
+ * @param hybrid The engine that is merging
+ */
+static void finishMerge(Hybrid *hybrid) {
+  if (hybrid->merging) {
+    pthread_join(hybrid->merger, NULL);
+    hybrid->merging = 0;
+  }
+  freeStaticIndex(hybrid->index, 0);
+  hybrid->index = hybrid->merged;
+  hybrid->merged = NULL;
+  applyShadow(hybrid->index, hybrid->shadow->root);
+
+  for (int i = 0; i < hybrid->unpackedCount; i++) {
+    HybridEntry *entry = &hybrid->unpacked[i];
+    if (getEntry(hybrid->shadow, entry->date) != NULL) {
+      free(entry->description);
+    } else {
+      // The key was live all along, so the delta doesn't have it
+      insertEntry(hybrid->delta, copyKey(entry->date), entry->description);
+    }
+  }
+  free(hybrid->unpacked);
+  hybrid->unpacked = NULL;
+  hybrid->unpackedCount = 0;
+
+  releaseDescriptions(hybrid->frozen->root);
+  freeBTree(hybrid->frozen);
+  hybrid->frozen = NULL;
+  freeBTree(hybrid->shadow);
+  hybrid->shadow = NULL;
+}
+
+/**
+ * Install a finished merge, and start a new one if the delta grew too large.
+ * @param hybrid The engine we are about to use
+ */
+static void maintainHybrid(Hybrid *hybrid) {
+  if (hybrid->frozen != NULL) {
+    if (!__atomic_load_n(&hybrid->finished, __ATOMIC_ACQUIRE)) {
+      return;
+    }
+    finishMerge(hybrid);
+  }
+  int changes = hybrid->delta->size + hybrid->index->removedCount;
+  if (changes >= HYBRID_DELTA && changes >= hybrid->index->size / HYBRID_RATIO) {
+    startMerge(hybrid);
+  }
+}
+
+/**
+ * Free a hybrid engine, a running merge is waited for.
+ * @param hybrid The engine we want to free
+ */
+void freeHybrid(Hybrid *hybrid) {
+  if (hybrid->frozen != NULL) {
+    finishMerge(hybrid);
+  }
+  freeStaticIndex(hybrid->index, 1);
+  freeBTree(hybrid->delta);
+  free(hybrid);
+}
+
+/**
+ * Find the description of a live entry of the index or the frozen delta.
+ * @param hybrid The engine we are searching in
+ * @param date The key we are searching
+ * @return The description or NULL if the entry is not there or removed during the merge
+ */
+static char *frozenEntry(Hybrid *hybrid, char *date) {
+  int position = staticFind(hybrid->index, date);
+  char *description = position >= 0 ? hybrid->index->descriptions[position] : NULL;
+  if (hybrid->frozen == NULL) {
+    return description;
+  }
+  if (description == NULL) {
+    description = getEntry(hybrid->frozen, date);
+  }
+  if (description != NULL && getEntry(hybrid->shadow, date) != NULL) {
+    return NULL;
+  }
+  return description;
+}
+
+/**
+ * Remember the removal of a live entry of the index or the frozen delta during a merge.
+ */
+static void shadowEntry(Hybrid *hybrid, char *date) {
+  char *description = malloc(sizeof(char));
+  if (description == NULL) {
+    exit(1);
+  }
+  description[0] = '\0';
+  insertEntry(hybrid->shadow, copyKey(date), description);
+}
+
+/**
+ * Insert an entry, a live entry keeps its description.
+ * @param hybrid The engine where we want to add an entry
+ * @param date The date we want to add, taken over
+ * @param description A description of the date, taken over
+ */
+void hybridInsertEntry(Hybrid *hybrid, char *date, char *description) {
+  maintainHybrid(hybrid);
+  if (frozenEntry(hybrid, date) != NULL) {
+    free(date);
+    free(description);
+    return;
+  }
+  insertEntry(hybrid->delta, date, description);
+}
+
+/**
+ * Find the description of an entry.
+ * @param hybrid The engine we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description or NULL if date is not found
+ */
+char *hybridGetEntry(Hybrid *hybrid, char *date) {
+  maintainHybrid(hybrid);
+  char *description = getEntry(hybrid->delta, date);
+  return description != NULL ? description : frozenEntry(hybrid, date);
+}
+
+/**
+ * Remove an entry.
+ * @param hybrid The engine where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not there), 1 if succeeded
+ */
+int hybridRemoveEntry(Hybrid *hybrid, char *date) {
+  maintainHybrid(hybrid);
+  if (removeEntry(hybrid->delta, date)) {
+    return 1;
+  }
+  if (hybrid->frozen != NULL) {
+    if (frozenEntry(hybrid, date) == NULL) {
+      return 0;
+    }
+    shadowEntry(hybrid, date);
+    return 1;
+  }
+  int position = staticFind(hybrid->index, date);
+  if (position < 0) {
+    return 0;
+  }
+  staticRemove(hybrid->index, position);
+  return 1;
+}
+
+/**
+ * Count the live entries between two dates.
+ * @param hybrid The engine where we will be counting
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The count of entries between begin and end
+ */
+int hybridCountBetweenEntries(Hybrid *hybrid, char *begin, char *end) {
+  maintainHybrid(hybrid);
+  StaticIndex *index = hybrid->index;
+  int count = countBetweenEntries(hybrid->delta, begin, end);
+  count += staticLiveBetween(index, staticBound(index, begin, 0), staticBound(index, end, 1));
+  if (hybrid->frozen != NULL) {
+    count += countBetweenEntries(hybrid->frozen, begin, end) - countBetweenEntries(hybrid->shadow, begin, end);
+  }
+  return count;
+}
+
+/**
+ * Aggregate the live entries of a subtree of the frozen delta between two dates that were not removed during the
+ * merge.
+ * @param hybrid The engine that is merging
+ * @param node The root of the subtree
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate The aggregate, extended
+ * @return The amount of entries
+ */
+static int aggregateFrozen(Hybrid *hybrid, BTreeNode *node, char *begin, char *end, Aggregate *aggregate) {
+  int count = 0;
+  for (int i = 0; i <= node->size; i++) {
+    // The child in front of key i only holds smaller keys, we skip it if they are all in front of the range
+    int beforeBegin = i < node->size && strcmp(node->dateKeys[i], begin) < 0;
+    if (!node->leaf && !beforeBegin) {
+      count += aggregateFrozen(hybrid, node->childNodes[i], begin, end, aggregate);
+    }
+    if (i == node->size || strcmp(node->dateKeys[i], end) > 0) {
+      break;
+    }
+    if (!beforeBegin && node->descriptionValues[i] != NULL && getEntry(hybrid->shadow, node->dateKeys[i]) == NULL) {
+      addEntryToAggregate(aggregate, node->descriptionValues[i]);
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Aggregate the live entries of the index and the frozen delta between two dates one by one, skipping the entries
+ * that were removed during the merge.
+ * @param hybrid The engine that is merging
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate The aggregate, extended
+ * @return The amount of entries
+ */
+static int aggregateMerging(Hybrid *hybrid, char *begin, char *end, Aggregate *aggregate) {
+  StaticIndex *index = hybrid->index;
+  int count = 0;
+  int to = staticBound(index, end, 1);
+  char date[DATE];
+  for (int position = staticBound(index, begin, 0); position < to; position++) {
+    if (!staticIsLive(index, position)) {
+      continue;
+    }
+    unpackDate(index->keys[position], date);
+    if (getEntry(hybrid->shadow, date) == NULL) {
+      addEntryToAggregate(aggregate, index->descriptions[position]);
+      count++;
+    }
+  }
+  return count + aggregateFrozen(hybrid, hybrid->frozen->root, begin, end, aggregate);
+}
+
+/**
+ * Take the entries that were removed during the merge out of the aggregate over the index and the frozen delta, for
+ * the keys of a subtree of the shadow tree between two dates.
+ * @param hybrid The engine that is merging
+ * @param node The root of the subtree
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param count The amount of entries, decreased
+ * @param aggregate The aggregate over the index and the frozen delta
+ * @return 1 if the aggregate is up to date, 0 if it lost its smallest or largest payload and has to be recalculated
+ */
+static int unshadowAggregate(Hybrid *hybrid, BTreeNode *node, char *begin, char *end, int *count,
+                             Aggregate *aggregate) {
+  for (int i = 0; i <= node->size; i++) {
+    // The child in front of key i only holds smaller keys, we skip it if they are all in front of the range
+    int beforeBegin = i < node->size && strcmp(node->dateKeys[i], begin) < 0;
+    if (!node->leaf && !beforeBegin && !unshadowAggregate(hybrid, node->childNodes[i], begin, end, count, aggregate)) {
+      return 0;
+    }
+    if (i == node->size || strcmp(node->dateKeys[i], end) > 0) {
+      break;
+    }
+    if (!beforeBegin && node->descriptionValues[i] != NULL) {
+      // A removed key is live in the index or in the frozen delta
+      int position = staticFind(hybrid->index, node->dateKeys[i]);
+      char *description = position >= 0 ? hybrid->index->descriptions[position]
+                                         : getEntry(hybrid->frozen, node->dateKeys[i]);
+      *count -= 1;
+      if (!removeEntryFromAggregate(aggregate, description)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/**
+ * Aggregate the live entries between two dates. The delta, the index and the frozen delta each add their aggregate
+ * over the range, out of their nodes or the segment tree of the index. During a merge the entries that were removed
+ * in the meantime are taken out again, unless one had the smallest or largest payload: then the index and the frozen
+ * delta are walked.
+ * @param hybrid The engine where we will be aggregating
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate Set to the aggregate over the entries
+ * @return The amount of entries
+ */
+int hybridAggregateBetweenEntries(Hybrid *hybrid, char *begin, char *end, Aggregate *aggregate) {
+  maintainHybrid(hybrid);
+  StaticIndex *index = hybrid->index;
+  int count = aggregateBetweenEntries(hybrid->delta, begin, end, aggregate);
+  Aggregate old;
+  emptyAggregate(&old);
+  int oldCount = staticAggregateBetween(index, staticBound(index, begin, 0), staticBound(index, end, 1), &old);
+  if (hybrid->frozen != NULL) {
+    Aggregate frozen;
+    oldCount += aggregateBetweenEntries(hybrid->frozen, begin, end, &frozen);
+    combineAggregates(&old, &frozen);
+    if (!unshadowAggregate(hybrid, hybrid->shadow->root, begin, end, &oldCount, &old)) {
+      emptyAggregate(&old);
+      oldCount = aggregateMerging(hybrid, begin, end, &old);
+    }
+  }
+  combineAggregates(aggregate, &old);
+  return count + oldCount;
+}
+
+/**
+ * Check if a key is within a range.
+ */
+static int inRange(char *date, char *start, char *end, int inclusiveEnd) {
+  int cmp = strcmp(date, end);
+  return (start == NULL || strcmp(date, start) >= 0) && (cmp < 0 || (inclusiveEnd && cmp == 0));
+}
+
+/**
+ * Shadow the live entries of a subtree of the frozen delta within a range, during a merge.
+ * @param hybrid The engine that is merging
+ * @param node The root of the subtree
+ * @param start The begin boundary (inclusive), NULL to start at the first entry
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if end itself should be removed too, 0 otherwise
+ * @return The amount of entries that were shadowed
+ */
+static int shadowFrozen(Hybrid *hybrid, BTreeNode *node, char *start, char *end, int inclusiveEnd) {
+  int removed = 0;
+  for (int i = 0; i <= node->size; i++) {
+    // The child in front of key i only holds smaller keys, we skip it if they are all in front of the range
+    int beforeStart = i < node->size && start != NULL && strcmp(node->dateKeys[i], start) < 0;
+    if (!node->leaf && !beforeStart) {
+      removed += shadowFrozen(hybrid, node->childNodes[i], start, end, inclusiveEnd);
+    }
+    if (i == node->size) {
+      break;
+    }
+    if (!inRange(node->dateKeys[i], start, end, inclusiveEnd)) {
+      if (!beforeStart) {
+        break;
+      }
+      continue;
+    }
+    if (node->descriptionValues[i] != NULL && getEntry(hybrid->shadow, node->dateKeys[i]) == NULL) {
+      shadowEntry(hybrid, node->dateKeys[i]);
+      removed++;
+    }
+  }
+  return removed;
+}
+
+/**
+ * Remove all entries between start and end.
+ * @param hybrid The engine where we want to remove entries
+ * @param start The begin boundary (inclusive), NULL to start at the first entry
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if end itself should be removed too, 0 otherwise
+ * @return The amount of (non-removed) entries that were removed
+ */
+int hybridRemoveRange(Hybrid *hybrid, char *start, char *end, int inclusiveEnd) {
+  maintainHybrid(hybrid);
+  StaticIndex *index = hybrid->index;
+  int removed = removeRangeBetween(hybrid->delta, start, end, inclusiveEnd);
+  int from = start == NULL ? 0 : staticBound(index, start, 0);
+  int to = staticBound(index, end, inclusiveEnd);
+  if (hybrid->frozen == NULL) {
+    return removed + staticRemoveBetween(index, from, to);
+  }
+
+  char date[DATE];
+  for (int position = from; position < to; position++) {
+    unpackDate(index->keys[position], date);
+    if (staticIsLive(index, position) && getEntry(hybrid->shadow, date) == NULL) {
+      shadowEntry(hybrid, date);
+      removed++;
+    }
+  }
+  return removed + shadowFrozen(hybrid, hybrid->frozen->root, start, end, inclusiveEnd);
+}
+
+/**
+ * Prepare a list for at most a given amount of edge entries.
+ */
+static void startEdgeList(EdgeList *list, int capacity, BTree *shadow) {
+  list->dates = malloc(sizeof(char[DATE]) * (capacity + 1));
+  list->descriptions = malloc(sizeof(char *) * (capacity + 1));
+  if (list->dates == NULL || list->descriptions == NULL) {
+    exit(1);
+  }
+  list->size = 0;
+  list->capacity = capacity;
+  list->shadow = shadow;
+}
+
+/**
+ * Visitor that adds an entry to an EdgeList, unless it was removed during a merge.
+ */
+static int addToEdgeList(char *date, char *description, void *context) {
+  EdgeList *list = context;
+  if (list->shadow != NULL && getEntry(list->shadow, date) != NULL) {
+    return 0;
+  }
+  memcpy(list->dates[list->size], date, DATE);
+  list->descriptions[list->size++] = description;
+  return 1;
+}
+
+/**
+ * Visit the first or last live entries. Every part (delta, index and frozen delta) hands over its own edge entries,
+ * they are merged in order.
+ * @param hybrid The engine we are working in
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int hybridEdgeEntries(Hybrid *hybrid, int last, int count, EntryVisitor visit, void *context) {
+  maintainHybrid(hybrid);
+  StaticIndex *index = hybrid->index;
+  EdgeList lists[3];
+  int parts = 0;
+
+  int live = hybrid->delta->root->recursiveSize;
+  startEdgeList(&lists[parts], count < live ? count : live, NULL);
+  edgeEntries(hybrid->delta, last, lists[parts].capacity, addToEdgeList, &lists[parts]);
+  parts++;
+
+  live = index->size - index->removedCount;
+  startEdgeList(&lists[parts], count < live ? count : live, hybrid->shadow);
+  for (int step = 0; step < index->size && lists[parts].size < lists[parts].capacity; step++) {
+    int position = last ? index->size - 1 - step : step;
+    if (staticIsLive(index, position)) {
+      char date[DATE];
+      unpackDate(index->keys[position], date);
+      addToEdgeList(date, index->descriptions[position], &lists[parts]);
+    }
+  }
+  parts++;
+
+  if (hybrid->frozen != NULL) {
+    live = hybrid->frozen->root->recursiveSize;
+    startEdgeList(&lists[parts], count < live ? count : live, hybrid->shadow);
+    edgeEntries(hybrid->frozen, last, lists[parts].capacity, addToEdgeList, &lists[parts]);
+    parts++;
+  }
+
+  // A key is live in one part at most, so we take the first (or last) head of the lists every time
+  int visited = 0;
+  int heads[3] = {0, 0, 0};
+  while (visited < count) {
+    int next = -1;
+    for (int part = 0; part < parts; part++) {
+      if (heads[part] == lists[part].size) {
+        continue;
+      }
+      int cmp = next < 0 ? 0 : strcmp(lists[part].dates[heads[part]], lists[next].dates[heads[next]]);
+      if (next < 0 || (last ? cmp > 0 : cmp < 0)) {
+        next = part;
+      }
+    }
+    if (next < 0) {
+      break;
+    }
+    visited += visit(lists[next].dates[heads[next]], lists[next].descriptions[heads[next]], context);
+    heads[next]++;
+  }
+
+  for (int part = 0; part < parts; part++) {
+    free(lists[part].dates);
+    free(lists[part].descriptions);
+  }
+  return visited;
+}
@@ -0,0 +1,72 @@
+#ifndef BTREE_HYBRID_H
+#define BTREE_HYBRID_H
+
+#include "btree.h"
+#include "staticindex.h"
+#include "compact.h"
+#include <pthread.h>
+
+#ifndef HYBRID_DELTA
+#define HYBRID_DELTA 4096 // a merge starts once the delta and the removals in the index hold this many entries...
+#endif
+#ifndef HYBRID_RATIO
+#define HYBRID_RATIO 8 // ...and at least this part of the index
+#endif
+
+/**
+ * Struct representing an entry of the frozen delta that can't be packed in the index, it goes back into the delta
+ */
+typedef struct HybridEntry {
+    char *date; // The key of the entry
+    char *description; // The description of the entry
+} HybridEntry;
+
+/**
+ * Struct representing the engine behind a BTree created by createHybridBTree. The old entries are in a static index,
+ * the recent writes in a small BTree, the delta. A key is live in at most one of them. A background thread merges
+ * the delta into a new index once it grows: the delta is frozen and a new one takes the writes. During the merge the
+ * index and the frozen delta are only read, removals of their entries are kept in the shadow tree and applied to the
+ * merged index when it replaces the old one.
+ */
+struct Hybrid {
+    StaticIndex *index; // The old entries
+    BTree *delta; // The recent writes
+    BTree *frozen; // The delta that is being merged, NULL if there is no merge
+    BTree *shadow; // The keys of index and frozen that were removed during the merge, NULL if there is no merge
+    pthread_t merger; // The thread that builds the merged index
+    int merging; // 1 while there is a merge
+    int finished; // Set by merger once merged is built
+    StaticIndex *merged; // The index built by merger
+    HybridEntry *unpacked; // The live entries of frozen that merger left out, because their key is not a date
+    int unpackedCount; // The amount of entries in unpacked
+};
+
+/*
+ * Functions for the creation and free-ing of hybrid engines
+ */
+BTree *createHybridBTree();
+
+Hybrid *createHybrid();
+
+void freeHybrid(Hybrid *hybrid);
+
+void buildHybrid(Hybrid *hybrid, CompactedEntry *entries, int count);
+
+/*
+ * Functions behind the BTree API for hybrid engines
+ */
+void hybridInsertEntry(Hybrid *hybrid, char *date, char *description);
+
+char *hybridGetEntry(Hybrid *hybrid, char *date);
+
+int hybridRemoveEntry(Hybrid *hybrid, char *date);
+
+int hybridCountBetweenEntries(Hybrid *hybrid, char *begin, char *end);
+
+int hybridAggregateBetweenEntries(Hybrid *hybrid, char *begin, char *end, Aggregate *aggregate);
+
+int hybridRemoveRange(Hybrid *hybrid, char *start, char *end, int inclusiveEnd);
+
+int hybridEdgeEntries(Hybrid *hybrid, int last, int count, EntryVisitor visit, void *context);
+
+#endif //BTREE_HYBRID_H
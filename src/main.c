@@ -1,4 +1,15 @@
 #include "./btree.h"
+#include "./shard.h"
+#include "./filter.h"
+#include "./bplustree.h"
+#include "./pagedtree.h"
+#include "./compact.h"
+#include "./hybrid.h"
+#include "./command.h"
+#include "./server.h"
+#include "./protocol.h"
+#include "./snapshot.h"
+#include <unistd.h>
 
 /**
  * Read a new command (= line) from stdin and return it.
@@ -39,186 +50,257 @@ char *getCommand() {
   return line_start;
 }
 
+/**
+ * Read a new frame of the binary protocol from stdin and return it, without the length in front of it.
+ * @param length Set to the length of the frame
+ * @return The frame or NULL at the end of stdin (also if the last frame is cut off)
+ */
+unsigned char *getFrame(size_t *length) {
+  unsigned char header[FRAME_LENGTH];
+  if (fread(header, 1, FRAME_LENGTH, stdin) != FRAME_LENGTH) {
+    return NULL;
+  }
+  *length = readU32(header);
+
+  unsigned char *frame = malloc(*length > 0 ? *length : 1);
+  if (frame == NULL) {
+    exit(1);
+  }
+  if (fread(frame, 1, *length, stdin) != *length) {
+    free(frame);
+    return NULL;
+  }
+  return frame;
+}
+
+/**
+ * Fill the tree with the entries of a snapshot.
+ * @param tree The tree, still empty
+ * @param path The file or pipe the snapshot comes from
+ * @return 1 if succeeded, 0 if the snapshot can't be read (the reason is printed)
+ */
+static int importSnapshot(BTree *tree, char *path) {
+  FILE *in = fopen(path, "rb");
+  if (in == NULL) {
+    perror(path);
+    return 0;
+  }
+  long long entries = readSnapshot(tree, in);
+  fclose(in);
+  if (entries < 0) {
+    fprintf(stderr, "%s is not a valid snapshot\n", path);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Write a snapshot of the live entries of the tree.
+ * @param tree The tree
+ * @param path The file or pipe the snapshot goes to
+ * @return 1 if succeeded, 0 if the snapshot can't be written (the reason is printed)
+ */
+static int exportSnapshot(BTree *tree, char *path) {
+  if (saveSnapshot(tree, path) < 0) {
+    fprintf(stderr, "Writing the snapshot to %s failed\n", path);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Print how the program is used.
+ * @param program The name of the program
+ * @return the exit code of the program
+ */
+static int usage(char *program) {
+  fprintf(stderr, "Usage: %s [-s] [-b] [-f] [-p] [-H] [-P path [-m frames]] [-c percent] [-B] [-I path] [-E path]\n"
+                  "       [-S directory] [-l path]\n", program);
+  return 1;
+}
+
 /**
  * The main function of the program, a loop that parses the commands given on stdin and performs the actions on the
  * BTree.
+ * Options:
+ *  -s  partition the entries on time range over independent BTree's
+ *  -b  write-optimized mode: buffer writes in the inner nodes and push them down in sorted batches
+ *  -f  keep a negative-lookup filter, so ? and - on absent dates mostly don't descend the tree
+ *  -p  keep the entries in a B+ tree (can't be combined with -s, -b and -f)
+ *  -H  keep the old entries in a static index and the recent writes in a small BTree, merged in the background
+ *      (can't be combined with -s, -b, -f and -p)
+ *  -P path  keep the entries in a B+ tree of pages in the file at path, only a buffer pool of them stays in memory
+ *           (can't be combined with -s, -b, -f, -p and -H)
+ *  -m frames  the amount of pages of 4 KiB the buffer pool of -P holds
+ *  -c percent  compact the tree by itself, a few entries per command, once its fill drops below percent (can't be
+ *              combined with -s, -p, -H and -P)
+ *  -B  speak the binary protocol (see protocol.h) instead of the line protocol
+ *  -I path  start with the entries of the snapshot (see snapshot.h) at path, which can be a pipe
+ *  -E path  write a snapshot of the live entries to path at the end, which can be a pipe
+ *  -S directory  let @ write snapshots to new files in directory, @ is refused without it
+ *  -l path  keep running and serve the commands of the clients of a Unix domain socket at path
  * @param argc
  * @param argv
  * @return the exit code of the program
  */
 int main(int argc, char *argv[]) {
-  BTree *tree = createBTree();
-  if (tree == NULL) {
+  int sharded = 0;
+  int buffered = 0;
+  int filtered = 0;
+  int bplus = 0;
+  int hybrid = 0;
+  int binary = 0;
+  char *socketPath = NULL;
+  char *pagePath = NULL;
+  int frames = PAGER_FRAMES;
+  int compactBelow = 0;
+  char *importPath = NULL;
+  char *exportPath = NULL;
+  char *snapshotDirectory = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "sbfpHBl:P:m:c:I:E:S:")) != -1) {
+    switch (option) {
+      case 's':
+        sharded = 1;
+        break;
+      case 'b':
+        buffered = 1;
+        break;
+      case 'f':
+        filtered = 1;
+        break;
+      case 'p':
+        bplus = 1;
+        break;
+      case 'H':
+        hybrid = 1;
+        break;
+      case 'B':
+        binary = 1;
+        break;
+      case 'l':
+        socketPath = optarg;
+        break;
+      case 'P':
+        pagePath = optarg;
+        break;
+      case 'm':
+        frames = atoi(optarg);
+        break;
+      case 'c':
+        compactBelow = atoi(optarg);
+        break;
+      case 'I':
+        importPath = optarg;
+        break;
+      case 'E':
+        exportPath = optarg;
+        break;
+      case 'S':
+        snapshotDirectory = optarg;
+        break;
+      default:
+        return usage(argv[0]);
+    }
+  }
+  if (frames <= 0 || compactBelow < 0 || compactBelow > 100) {
+    return usage(argv[0]);
+  }
+  if (bplus && (sharded || buffered || filtered)) {
+    fprintf(stderr, "The B+ tree engine (-p) can't be combined with -s, -b or -f\n");
+    return 1;
+  }
+  if (hybrid && (sharded || buffered || filtered || bplus)) {
+    fprintf(stderr, "The hybrid engine (-H) can't be combined with -s, -b, -f or -p\n");
+    return 1;
+  }
+  if (pagePath != NULL && (sharded || buffered || filtered || bplus || hybrid)) {
+    fprintf(stderr, "The paged mode (-P) can't be combined with -s, -b, -f, -p or -H\n");
+    return 1;
+  }
+  if (compactBelow > 0 && (sharded || bplus || hybrid || pagePath != NULL)) {
+    fprintf(stderr, "Compaction (-c) can't be combined with -s, -p, -H or -P\n");
     return 1;
   }
 
-  char *line;
-
-  char *date;
-  char *description;
-  char *sdate;
-
-  while ((line = getCommand()) != NULL && strlen(line) > 0) {
-    switch (*line) {
-      case '+':
-        if (strlen(line) < DATE + 1) {
-          freeBTree(tree);
-          free(line);
-          printf("This is an invalid command. The program will now exit");
-          return 1;
-        }
-
-        // We willen een date met description toevoegen
-        date = malloc(sizeof(char) * DATE);
-        if (date == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-
-        memcpy(date, &line[1], DATE - 1);
-        date[DATE - 1] = '\0';
-
-        description = malloc(sizeof(char) * (strlen(line) - DATE - 1));
-        if (description == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-        memcpy(description, &line[1 + DATE], strlen(line) - DATE - 2);
-        description[strlen(line) - DATE - 2] = '\0';
-
-        insertEntry(tree, date, description);
-
-        free(line);
-        line = NULL;
-        date = NULL;
-        description = NULL;
+  BTree *tree;
+  if (pagePath != NULL) {
+    tree = createPagedBTree(pagePath, frames);
+  } else if (bplus) {
+    tree = createBPlusBTree();
+  } else if (hybrid) {
+    tree = createHybridBTree();
+  } else {
+    tree = sharded ? createShardedBTree() : createBTree();
+  }
+  if (tree == NULL) {
+    return 1;
+  }
+  tree->snapshotDirectory = snapshotDirectory;
+  if (sharded) {
+    tree->shards->buffered = buffered;
+    tree->shards->filtered = filtered;
+  } else if (!bplus && !hybrid && pagePath == NULL) {
+    tree->buffered = buffered;
+    tree->compactBelow = compactBelow;
+    tree->compactCheck = COMPACT_CHECK;
+    if (filtered) {
+      enableFilter(tree);
+    }
+  }
 
-        break;
-      case '-':
-        if (strlen(line) < DATE) {
-          freeBTree(tree);
-          free(line);
-          printf("This is an invalid command. The program will now exit");
-          return 1;
-        }
-
-        // We willen een date verwijderen
-        date = malloc(sizeof(char) * DATE);
-        if (date == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-        memcpy(date, &line[1], DATE - 1);
-        date[DATE - 1] = '\0';
-
-        int removeStatus = removeEntry(tree, date);
-
-        if (removeStatus) {
-          printf("-\n");
-        } else {
-          printf("?\n");
-        }
-
-        free(line);
-        line = NULL;
-        free(date);
-        date = NULL;
+  if (importPath != NULL && !importSnapshot(tree, importPath)) {
+    freeBTree(tree);
+    return 1;
+  }
 
-        break;
-      case '?':
-        if (strlen(line) < DATE) {
-          freeBTree(tree);
-          free(line);
-          printf("This is an invalid command. The program will now exit");
-          return 1;
-        }
-
-        // We willen kijken of een bepaalde date in de boom zit
-        date = malloc(sizeof(char) * DATE);
-        if (date == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-        memcpy(date, &line[1], DATE - 1);
-        date[DATE - 1] = '\0';
-
-        char *result = getEntry(tree, date);
-
-        if (result != NULL) {
-          printf("!%s\n", result);
-        } else {
-          printf("?\n");
-        }
-
-        free(line);
-        line = NULL;
-        free(date);
-        date = NULL;
+  if (socketPath != NULL) {
+    // Server mode, the tree stays resident and the commands come from the clients of the socket
+    int status = runServer(tree, socketPath, binary);
+    if (status == 0 && exportPath != NULL && !exportSnapshot(tree, exportPath)) {
+      status = 1;
+    }
+    freeBTree(tree);
+    return status;
+  }
 
-        break;
-      case '#':
-        if (strlen(line) < DATE + DATE + 1) {
-          freeBTree(tree);
-          free(line);
-          printf("This is an invalid command. The program will now exit");
-          return 1;
-        }
-        date = malloc(sizeof(char) * DATE);
-        if (date == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-        memcpy(date, &line[1], DATE - 1);
-        date[DATE - 1] = '\0';
-
-        sdate = malloc(sizeof(char) * DATE);
-        if (sdate == NULL) {
-          freeBTree(tree);
-          free(line);
-          return 1;
-        }
-        memcpy(sdate, &line[1 + DATE], DATE - 1);
-        sdate[DATE - 1] = '\0';
-
-        int amount;
-        if (strcmp(date, sdate) < 0) {
-          amount = countBetweenEntries(tree, date, sdate);
-        } else {
-          amount = countBetweenEntries(tree, sdate, date);
-        }
-        printf("%i\n", amount);
-
-        free(line);
-        line = NULL;
-        free(date);
-        date = NULL;
-        free(sdate);
-        sdate = NULL;
+  if (binary) {
+    unsigned char *frame;
+    size_t length;
+    while ((frame = getFrame(&length)) != NULL) {
+      int status = executeFrame(tree, frame, length, stdout);
+      free(frame);
 
-        break;
-      case EOF:
-      case '\0':
-      case '\n':
-        // Exit the program
-        free(line);
-        line = NULL;
+      if (status == COMMAND_INVALID) {
+        fprintf(stderr, "This is an invalid frame. The program will now exit\n");
         freeBTree(tree);
-
-        return 0;
-      default:
+        return 1;
+      }
+      if (status == COMMAND_EXIT) {
+        break;
+      }
+    }
+  } else {
+    char *line;
+    while ((line = getCommand()) != NULL && strlen(line) > 0) {
+      int status = executeCommand(tree, line, stdout);
+      free(line);
+      line = NULL;
+
+      if (status == COMMAND_INVALID) {
         // Invalid input command, exit program with exit code != 0
         printf("This is an invalid command. The program will now exit");
-
-        free(line);
-        line = NULL;
         freeBTree(tree);
-
         return 1;
+      }
+      if (status == COMMAND_EXIT) {
+        // Exit the program
+        break;
+      }
     }
   }
-}
\ No newline at end of file
+  int status = exportPath != NULL && !exportSnapshot(tree, exportPath) ? 1 : 0;
+  freeBTree(tree);
+  return status;
+}
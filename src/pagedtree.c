@@ -0,0 +1,989 @@
+#include "pagedtree.h"
+#include "aggregate.h"
+
+_Static_assert(sizeof(PagedInner) <= PAGE_SIZE, "an inner page doesn't fit in a page, lower PAGED_FANOUT");
+_Static_assert(sizeof(PagedLeaf) == PAGE_SIZE, "a leaf page doesn't fill a page");
+_Static_assert(PAGED_VALUES >= 4 * PAGED_INLINE_DESCRIPTION,
+               "a leaf page doesn't fit its descriptions, lower PAGED_LEAF");
+
+/**
+ * Struct representing an entry of a leaf while leafs are rewritten
+ */
+typedef struct PagedEntry {
+    char *key; // The key of the entry
+    uint32_t length; // The length of the description
+    uint32_t location; // The first overflow page of a long description
+    char *bytes; // The description if it is short
+} PagedEntry;
+
+/**
+ * Struct representing the inner pages on the path from the root to a leaf, they stay pinned while they are used
+ */
+typedef struct PagedPath {
+    int height; // The amount of inner pages on the path
+    uint32_t pages[PAGED_MAX_HEIGHT]; // The inner pages, from the root down, PAGE_NONE once a page is freed
+    PagedInner *inner[PAGED_MAX_HEIGHT]; // The contents of the pages
+    int indexes[PAGED_MAX_HEIGHT]; // The index of the child we took in every inner page
+    uint32_t leafPage; // The leaf at the end of the path
+} PagedPath;
+
+/**
+ * Create a BTree whose entries are kept in a paged B+ tree.
+ * @param path The file the pages are kept in, it is overwritten
+ * @param frames The amount of pages the buffer pool keeps in memory
+ * @return A created BTree or NULL if we are out of memory or the file could not be created
+ */
+BTree *createPagedBTree(char *path, int frames) {
+  BTree *tree = (BTree *) malloc(sizeof(BTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->size = 0;
+  tree->root = NULL;
+  tree->shards = NULL;
+  tree->detached.nodes = NULL;
+  tree->detached.size = 0;
+  tree->detached.capacity = 0;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->buffered = 0;
+  tree->filter = NULL;
+  tree->bplus = NULL;
+  tree->hybrid = NULL;
+  tree->compaction = NULL;
+  tree->compactBelow = 0;
+  tree->compactCheck = 0;
+  tree->snapshotDirectory = NULL;
+  tree->paged = createPagedTree(path, frames);
+  if (tree->paged == NULL) {
+    free(tree);
+    return NULL;
+  }
+  return tree;
+}
+
+/**
+ * Create an empty paged tree.
+ * @param path The file the pages are kept in, it is overwritten
+ * @param frames The amount of pages the buffer pool keeps in memory
+ * @return The created paged tree or NULL if we are out of memory or the file could not be created
+ */
+PagedTree *createPagedTree(char *path, int frames) {
+  PagedTree *tree = malloc(sizeof(PagedTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->pager = openPager(path, frames);
+  if (tree->pager == NULL) {
+    free(tree);
+    return NULL;
+  }
+  PagedLeaf *root = allocatePage(tree->pager, &tree->root);
+  root->node.leaf = 1;
+  unpinPage(tree->pager, tree->root, 1);
+  tree->height = 0;
+  tree->size = 0;
+  tree->description = NULL;
+  tree->descriptionCapacity = 0;
+  return tree;
+}
+
+/**
+ * Free a paged tree, its file is removed.
+ * @param tree The paged tree we want to free
+ */
+void freePagedTree(PagedTree *tree) {
+  closePager(tree->pager);
+  free(tree->description);
+  free(tree);
+}
+
+/**
+ * The amount of keys that are smaller than (or equal to) a key.
+ * @param keys The sorted keys we are searching in
+ * @param size The amount of keys
+ * @param search The key we are searching
+ * @param inclusive 1 to count the keys equal to search as well, 0 otherwise
+ * @return The amount of keys
+ */
+static int rankInKeys(char keys[][DATE], int size, char *search, int inclusive) {
+  int low = 0;
+  int high = size;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    int cmp = strcmp(keys[middle], search);
+    if (cmp < 0 || (inclusive && cmp == 0)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * The amount of bytes a description takes in the values of a leaf.
+ */
+static uint32_t inlineLength(uint32_t length) {
+  return length > PAGED_INLINE_DESCRIPTION ? 0 : length;
+}
+
+/**
+ * Write a long description to a new chain of overflow pages.
+ * @return The first page of the chain
+ */
+static uint32_t writeOverflow(PagedTree *tree, char *description, uint32_t length) {
+  uint32_t first;
+  uint32_t page;
+  PagedOverflow *overflow = allocatePage(tree->pager, &first);
+  page = first;
+  while (1) {
+    uint32_t part = length < sizeof(overflow->data) ? length : sizeof(overflow->data);
+    memcpy(overflow->data, description, part);
+    description += part;
+    length -= part;
+    if (length == 0) break;
+
+    uint32_t next;
+    PagedOverflow *nextOverflow = allocatePage(tree->pager, &next);
+    overflow->next = next;
+    unpinPage(tree->pager, page, 1);
+    overflow = nextOverflow;
+    page = next;
+  }
+  unpinPage(tree->pager, page, 1);
+  return first;
+}
+
+/**
+ * Read a long description from its chain of overflow pages.
+ */
+static void readOverflow(PagedTree *tree, uint32_t page, char *description, uint32_t length) {
+  while (length > 0) {
+    PagedOverflow *overflow = pinPage(tree->pager, page);
+    uint32_t part = length < sizeof(overflow->data) ? length : sizeof(overflow->data);
+    memcpy(description, overflow->data, part);
+    description += part;
+    length -= part;
+    uint32_t next = overflow->next;
+    unpinPage(tree->pager, page, 0);
+    page = next;
+  }
+}
+
+/**
+ * Give the pages of a chain of overflow pages back to the pager.
+ */
+static void freeOverflow(PagedTree *tree, uint32_t page) {
+  while (page != PAGE_NONE) {
+    PagedOverflow *overflow = pinPage(tree->pager, page);
+    uint32_t next = overflow->next;
+    unpinPage(tree->pager, page, 0);
+    freePage(tree->pager, page);
+    page = next;
+  }
+}
+
+/**
+ * Descend to the leaf where a key belongs. The inner pages on the path and the leaf are pinned.
+ * @param tree The paged tree we are searching in
+ * @param search The key we are searching, NULL for the first leaf
+ * @param path Filled with the path to the leaf
+ * @return The leaf
+ */
+static PagedLeaf *descend(PagedTree *tree, char *search, PagedPath *path) {
+  uint32_t page = tree->root;
+  PagedNode *node = pinPage(tree->pager, page);
+  path->height = tree->height;
+  for (int level = 0; !node->leaf; level++) {
+    PagedInner *inner = (PagedInner *) node;
+    int index = search == NULL ? 0 : rankInKeys(inner->keys, node->size, search, 1);
+    path->pages[level] = page;
+    path->inner[level] = inner;
+    path->indexes[level] = index;
+    page = inner->children[index];
+    node = pinPage(tree->pager, page);
+  }
+  path->leafPage = page;
+  return (PagedLeaf *) node;
+}
+
+/**
+ * Unpin the inner pages of a path.
+ * @param dirty 1 if the pages were changed
+ */
+static void releasePath(PagedTree *tree, PagedPath *path, int dirty) {
+  for (int level = 0; level < path->height; level++) {
+    if (path->pages[level] != PAGE_NONE) {
+      unpinPage(tree->pager, path->pages[level], dirty);
+    }
+  }
+}
+
+/**
+ * Update the counts on a path after entries were added to or removed from the leaf at its end.
+ */
+static void updateCounts(PagedTree *tree, PagedPath *path, int update) {
+  for (int level = 0; level < path->height; level++) {
+    path->inner[level]->counts[path->indexes[level]] += update;
+  }
+  tree->size += update;
+}
+
+/**
+ * The amount of entries underneath an inner page.
+ */
+static int innerCount(PagedInner *inner) {
+  int count = 0;
+  for (int i = 0; i <= inner->node.size; i++) {
+    count += inner->counts[i];
+  }
+  return count;
+}
+
+static char *copyDescription(PagedTree *tree, PagedLeaf *leaf, int index);
+
+/**
+ * Calculate the aggregate over the entries of a leaf, long descriptions are read from their overflow pages.
+ * @param tree The paged tree we are working in
+ * @param leaf The leaf, pinned
+ * @param aggregate Set to the aggregate
+ */
+static void leafAggregate(PagedTree *tree, PagedLeaf *leaf, Aggregate *aggregate) {
+  emptyAggregate(aggregate);
+  for (int i = 0; i < leaf->node.size; i++) {
+    addEntryToAggregate(aggregate, copyDescription(tree, leaf, i));
+  }
+}
+
+/**
+ * Calculate the aggregate over the entries underneath an inner page.
+ */
+static void innerAggregate(PagedInner *inner, Aggregate *aggregate) {
+  emptyAggregate(aggregate);
+  for (int i = 0; i <= inner->node.size; i++) {
+    combineAggregates(aggregate, &inner->aggregates[i]);
+  }
+}
+
+/**
+ * Add a new entry to the aggregates on a path.
+ */
+static void addToAggregates(PagedPath *path, char *description) {
+  for (int level = 0; level < path->height; level++) {
+    addEntryToAggregate(&path->inner[level]->aggregates[path->indexes[level]], description);
+  }
+}
+
+/**
+ * Take an entry out of the aggregates on the path to the leaf it was in. We go up from the leaf, so an aggregate that
+ * has to be recalculated combines the aggregates below it that are up to date already.
+ * @param tree The paged tree we are working in
+ * @param path The path to the leaf
+ * @param leaf The leaf, pinned, the entry is taken out of it already
+ * @param description The description of the entry
+ */
+static void removeFromAggregates(PagedTree *tree, PagedPath *path, PagedLeaf *leaf, char *description) {
+  for (int level = path->height - 1; level >= 0; level--) {
+    Aggregate *aggregate = &path->inner[level]->aggregates[path->indexes[level]];
+    if (removeEntryFromAggregate(aggregate, description)) {
+      continue;
+    }
+    if (level == path->height - 1) {
+      leafAggregate(tree, leaf, aggregate);
+    } else {
+      innerAggregate(path->inner[level + 1], aggregate);
+    }
+  }
+}
+
+/**
+ * Recalculate the aggregates on the path to a leaf, after a run of entries was taken out of it.
+ */
+static void recalculateAggregates(PagedTree *tree, PagedPath *path, PagedLeaf *leaf) {
+  for (int level = path->height - 1; level >= 0; level--) {
+    Aggregate *aggregate = &path->inner[level]->aggregates[path->indexes[level]];
+    if (level == path->height - 1) {
+      leafAggregate(tree, leaf, aggregate);
+    } else {
+      innerAggregate(path->inner[level + 1], aggregate);
+    }
+  }
+}
+
+/**
+ * Collect the entries of a leaf.
+ * @param leaf The leaf, the entries point into it
+ * @param entries Filled with the entries
+ * @return The amount of entries
+ */
+static int gatherEntries(PagedLeaf *leaf, PagedEntry *entries) {
+  for (int i = 0; i < leaf->node.size; i++) {
+    entries[i].key = leaf->keys[i];
+    entries[i].length = leaf->lengths[i];
+    entries[i].location = leaf->locations[i];
+    entries[i].bytes = &leaf->values[leaf->locations[i]];
+  }
+  return leaf->node.size;
+}
+
+/**
+ * Add an entry after the last entry of a leaf.
+ */
+static void appendEntry(PagedLeaf *leaf, PagedEntry *entry) {
+  int index = leaf->node.size++;
+  memcpy(leaf->keys[index], entry->key, DATE);
+  leaf->lengths[index] = entry->length;
+  if (entry->length > PAGED_INLINE_DESCRIPTION) {
+    leaf->locations[index] = entry->location;
+  } else {
+    memcpy(&leaf->values[leaf->used], entry->bytes, entry->length);
+    leaf->locations[index] = leaf->used;
+    leaf->used += entry->length;
+  }
+}
+
+/**
+ * The amount of bytes the descriptions of a range of entries take in the values of a leaf.
+ */
+static uint32_t entriesLength(PagedEntry *entries, int from, int to) {
+  uint32_t length = 0;
+  for (int i = from; i < to; i++) {
+    length += inlineLength(entries[i].length);
+  }
+  return length;
+}
+
+/**
+ * Rewrite a leaf without the holes that removed entries left in its values.
+ */
+static void compactLeaf(PagedLeaf *leaf) {
+  PagedLeaf old;
+  PagedEntry entries[PAGED_LEAF];
+  memcpy(&old, leaf, sizeof(PagedLeaf));
+  int count = gatherEntries(&old, entries);
+  leaf->node.size = 0;
+  leaf->used = 0;
+  for (int i = 0; i < count; i++) {
+    appendEntry(leaf, &entries[i]);
+  }
+}
+
+static void splitInner(PagedTree *tree, PagedPath *path, int level);
+
+/**
+ * Add a new right sibling next to a page that was split, in the parent of the page (or in a new root).
+ * @param tree The paged tree we are working in
+ * @param path The path to the page
+ * @param level The level of the parent in path, -1 if the page is the root
+ * @param left The page that was split
+ * @param leftCount The amount of entries underneath left
+ * @param leftAggregate The aggregate over the entries underneath left
+ * @param separator The smallest key underneath right
+ * @param right The new right sibling
+ * @param rightCount The amount of entries underneath right
+ * @param rightAggregate The aggregate over the entries underneath right
+ */
+static void addChild(PagedTree *tree, PagedPath *path, int level, uint32_t left, int leftCount,
+                     Aggregate *leftAggregate, char *separator, uint32_t right, int rightCount,
+                     Aggregate *rightAggregate) {
+  if (level < 0) {
+    // De root is gesplitst, we moeten een nieuwe root aanmaken
+    uint32_t page;
+    PagedInner *root = allocatePage(tree->pager, &page);
+    root->node.size = 1;
+    memcpy(root->keys[0], separator, DATE);
+    root->children[0] = left;
+    root->children[1] = right;
+    root->counts[0] = leftCount;
+    root->counts[1] = rightCount;
+    root->aggregates[0] = *leftAggregate;
+    root->aggregates[1] = *rightAggregate;
+    unpinPage(tree->pager, page, 1);
+    tree->root = page;
+    tree->height++;
+    return;
+  }
+
+  PagedInner *parent = path->inner[level];
+  int index = path->indexes[level];
+  int size = parent->node.size;
+  memmove(parent->keys[index + 1], parent->keys[index], DATE * (size - index));
+  memmove(&parent->children[index + 2], &parent->children[index + 1], sizeof(uint32_t) * (size - index));
+  memmove(&parent->counts[index + 2], &parent->counts[index + 1], sizeof(int) * (size - index));
+  memmove(&parent->aggregates[index + 2], &parent->aggregates[index + 1], sizeof(Aggregate) * (size - index));
+  memcpy(parent->keys[index], separator, DATE);
+  parent->children[index + 1] = right;
+  parent->counts[index] = leftCount;
+  parent->counts[index + 1] = rightCount;
+  parent->aggregates[index] = *leftAggregate;
+  parent->aggregates[index + 1] = *rightAggregate;
+  parent->node.size++;
+
+  if (parent->node.size > PAGED_FANOUT - 1) {
+    splitInner(tree, path, level);
+  }
+}
+
+/**
+ * Split an inner page with one key too many, the middle key moves up to the parent.
+ * @param tree The paged tree we are working in
+ * @param path The path to the page
+ * @param level The level of the page in path
+ */
+static void splitInner(PagedTree *tree, PagedPath *path, int level) {
+  PagedInner *node = path->inner[level];
+  uint32_t page;
+  PagedInner *right = allocatePage(tree->pager, &page);
+
+  int keep = node->node.size / 2;
+  int moved = node->node.size - keep - 1;
+  char separator[DATE];
+  memcpy(separator, node->keys[keep], DATE);
+  memcpy(right->keys, node->keys[keep + 1], DATE * moved);
+  memcpy(right->children, &node->children[keep + 1], sizeof(uint32_t) * (moved + 1));
+  memcpy(right->counts, &node->counts[keep + 1], sizeof(int) * (moved + 1));
+  memcpy(right->aggregates, &node->aggregates[keep + 1], sizeof(Aggregate) * (moved + 1));
+  right->node.size = moved;
+  node->node.size = keep;
+
+  Aggregate leftAggregate;
+  Aggregate rightAggregate;
+  innerAggregate(node, &leftAggregate);
+  innerAggregate(right, &rightAggregate);
+  addChild(tree, path, level - 1, path->pages[level], innerCount(node), &leftAggregate, separator, page,
+           innerCount(right), &rightAggregate);
+  unpinPage(tree->pager, page, 1);
+}
+
+/**
+ * Split a full leaf while an entry is inserted, the upper half moves to a new leaf right of it. The entries are split
+ * in the middle, unless a half would not fit its descriptions.
+ * @param tree The paged tree we are working in
+ * @param path The path to the leaf
+ * @param leaf The leaf we are splitting
+ * @param entry The entry we are inserting
+ * @param index The index of the entry in the leaf
+ */
+static void splitLeaf(PagedTree *tree, PagedPath *path, PagedLeaf *leaf, PagedEntry *entry, int index) {
+  PagedLeaf old;
+  PagedEntry entries[PAGED_LEAF + 1];
+  memcpy(&old, leaf, sizeof(PagedLeaf));
+  int count = gatherEntries(&old, entries);
+  memmove(&entries[index + 1], &entries[index], sizeof(PagedEntry) * (count - index));
+  entries[index] = *entry;
+  count++;
+
+  int keep = count / 2;
+  while (keep > 1 && entriesLength(entries, 0, keep) > PAGED_VALUES) keep--;
+  while (keep < count - 1 && entriesLength(entries, keep, count) > PAGED_VALUES) keep++;
+
+  uint32_t page;
+  PagedLeaf *right = allocatePage(tree->pager, &page);
+  right->node.leaf = 1;
+  leaf->node.size = 0;
+  leaf->used = 0;
+  for (int i = 0; i < count; i++) {
+    appendEntry(i < keep ? leaf : right, &entries[i]);
+  }
+
+  right->previous = path->leafPage;
+  right->next = leaf->next;
+  if (right->next != PAGE_NONE) {
+    PagedLeaf *next = pinPage(tree->pager, right->next);
+    next->previous = page;
+    unpinPage(tree->pager, right->next, 1);
+  }
+  leaf->next = page;
+
+  Aggregate leftAggregate;
+  Aggregate rightAggregate;
+  leafAggregate(tree, leaf, &leftAggregate);
+  leafAggregate(tree, right, &rightAggregate);
+  addChild(tree, path, path->height - 1, path->leafPage, leaf->node.size, &leftAggregate, right->keys[0], page,
+           right->node.size, &rightAggregate);
+  unpinPage(tree->pager, page, 1);
+}
+
+/**
+ * Insert an entry. The paged tree keeps its own copy of the entry, so date and description are freed. Like
+ * overwriteEntry, an entry that is already in the tree keeps its description.
+ * @param tree The paged tree where we want to add an entry
+ * @param date The date we want to add
+ * @param description A description of the date
+ */
+void pagedInsertEntry(PagedTree *tree, char *date, char *description) {
+  PagedPath path;
+  PagedLeaf *leaf = descend(tree, date, &path);
+
+  int index = rankInKeys(leaf->keys, leaf->node.size, date, 0);
+  if (index < leaf->node.size && strcmp(leaf->keys[index], date) == 0) {
+    unpinPage(tree->pager, path.leafPage, 0);
+    releasePath(tree, &path, 0);
+    free(date);
+    free(description);
+    return;
+  }
+
+  char key[DATE] = {0};
+  strncpy(key, date, DATE - 1);
+  PagedEntry entry = {key, strlen(description), PAGE_NONE, description};
+  if (entry.length > PAGED_INLINE_DESCRIPTION) {
+    entry.location = writeOverflow(tree, description, entry.length);
+  }
+
+  uint32_t length = inlineLength(entry.length);
+  if (leaf->node.size < PAGED_LEAF && leaf->used + length > PAGED_VALUES) {
+    PagedEntry entries[PAGED_LEAF];
+    int count = gatherEntries(leaf, entries);
+    if (entriesLength(entries, 0, count) + length <= PAGED_VALUES) {
+      compactLeaf(leaf);
+    }
+  }
+  updateCounts(tree, &path, +1);
+  addToAggregates(&path, description);
+  if (leaf->node.size < PAGED_LEAF && leaf->used + length <= PAGED_VALUES) {
+    int size = leaf->node.size;
+    memmove(leaf->keys[index + 1], leaf->keys[index], DATE * (size - index));
+    memmove(&leaf->lengths[index + 1], &leaf->lengths[index], sizeof(uint32_t) * (size - index));
+    memmove(&leaf->locations[index + 1], &leaf->locations[index], sizeof(uint32_t) * (size - index));
+    memcpy(leaf->keys[index], key, DATE);
+    leaf->lengths[index] = entry.length;
+    if (length == entry.length) {
+      memcpy(&leaf->values[leaf->used], description, length);
+      leaf->locations[index] = leaf->used;
+      leaf->used += length;
+    } else {
+      leaf->locations[index] = entry.location;
+    }
+    leaf->node.size++;
+  } else {
+    splitLeaf(tree, &path, leaf, &entry, index);
+  }
+
+  unpinPage(tree->pager, path.leafPage, 1);
+  releasePath(tree, &path, 1);
+  free(date);
+  free(description);
+}
+
+/**
+ * Copy the description of an entry of a leaf into the description of the tree.
+ * @param tree The paged tree we are working in
+ * @param leaf The leaf, pinned
+ * @param index The index of the entry in the leaf
+ * @return The copy, valid until the next copy
+ */
+static char *copyDescription(PagedTree *tree, PagedLeaf *leaf, int index) {
+  uint32_t length = leaf->lengths[index];
+  if (length + 1 > tree->descriptionCapacity) {
+    char *description = realloc(tree->description, length + 1);
+    if (description == NULL) {
+      exit(1);
+    }
+    tree->description = description;
+    tree->descriptionCapacity = length + 1;
+  }
+  if (length > PAGED_INLINE_DESCRIPTION) {
+    readOverflow(tree, leaf->locations[index], tree->description, length);
+  } else {
+    memcpy(tree->description, &leaf->values[leaf->locations[index]], length);
+  }
+  tree->description[length] = '\0';
+  return tree->description;
+}
+
+/**
+ * Find the description of an entry.
+ * @param tree The paged tree we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description or NULL if date is not found, the description is valid until the next call
+ */
+char *pagedGetEntry(PagedTree *tree, char *date) {
+  uint32_t page = tree->root;
+  PagedNode *node = pinPage(tree->pager, page);
+  while (!node->leaf) {
+    PagedInner *inner = (PagedInner *) node;
+    uint32_t child = inner->children[rankInKeys(inner->keys, node->size, date, 1)];
+    unpinPage(tree->pager, page, 0);
+    page = child;
+    node = pinPage(tree->pager, page);
+  }
+
+  PagedLeaf *leaf = (PagedLeaf *) node;
+  int index = rankInKeys(leaf->keys, node->size, date, 0);
+  if (index == node->size || strcmp(leaf->keys[index], date) != 0) {
+    unpinPage(tree->pager, page, 0);
+    return NULL;
+  }
+
+  char *description = copyDescription(tree, leaf, index);
+  unpinPage(tree->pager, page, 0);
+  return description;
+}
+
+/**
+ * Remove a child of an inner page on a path. An inner page that loses its last child is freed and removed from its
+ * own parent.
+ * @param tree The paged tree we are working in
+ * @param path The path through the inner page
+ * @param level The level of the inner page in path
+ * @param child The index of the child, its count should be 0 already
+ */
+static void removeChild(PagedTree *tree, PagedPath *path, int level, int child) {
+  PagedInner *parent = path->inner[level];
+  if (parent->node.size == 0) {
+    unpinPage(tree->pager, path->pages[level], 0);
+    freePage(tree->pager, path->pages[level]);
+    path->pages[level] = PAGE_NONE;
+    removeChild(tree, path, level - 1, path->indexes[level - 1]);
+    return;
+  }
+
+  int size = parent->node.size;
+  int key = child > 0 ? child - 1 : 0;
+  memmove(parent->keys[key], parent->keys[key + 1], DATE * (size - key - 1));
+  memmove(&parent->children[child], &parent->children[child + 1], sizeof(uint32_t) * (size - child));
+  memmove(&parent->counts[child], &parent->counts[child + 1], sizeof(int) * (size - child));
+  memmove(&parent->aggregates[child], &parent->aggregates[child + 1], sizeof(Aggregate) * (size - child));
+  parent->node.size--;
+}
+
+/**
+ * Link the neighbours of a leaf that is taken out of the tree to each other.
+ */
+static void unlinkLeaf(PagedTree *tree, uint32_t previous, uint32_t next) {
+  if (previous != PAGE_NONE) {
+    PagedLeaf *leaf = pinPage(tree->pager, previous);
+    leaf->next = next;
+    unpinPage(tree->pager, previous, 1);
+  }
+  if (next != PAGE_NONE) {
+    PagedLeaf *leaf = pinPage(tree->pager, next);
+    leaf->previous = previous;
+    unpinPage(tree->pager, next, 1);
+  }
+}
+
+/**
+ * Repair the tree after entries were removed from the leaf at the end of a path, the leaf is unpinned. An empty leaf
+ * is taken out, a leaf that is less than a quarter full is merged with a sibling if both fit in one page. Inner
+ * pages are only taken out once they are empty.
+ * @param tree The paged tree we are working in
+ * @param path The path to the leaf
+ * @param leaf The leaf that lost entries
+ */
+static void repairLeaf(PagedTree *tree, PagedPath *path, PagedLeaf *leaf) {
+  int size = leaf->node.size;
+  uint32_t previous = leaf->previous;
+  uint32_t next = leaf->next;
+  unpinPage(tree->pager, path->leafPage, 1);
+  if (path->height == 0 || (size > 0 && size >= PAGED_LEAF / 4)) {
+    return;
+  }
+
+  int level = path->height - 1;
+  PagedInner *parent = path->inner[level];
+  int index = path->indexes[level];
+  if (size == 0) {
+    unlinkLeaf(tree, previous, next);
+    freePage(tree->pager, path->leafPage);
+    removeChild(tree, path, level, index);
+    return;
+  }
+
+  int first = index < parent->node.size ? index : index - 1;
+  if (first < 0) {
+    return;
+  }
+  uint32_t leftPage = parent->children[first];
+  uint32_t rightPage = parent->children[first + 1];
+  PagedLeaf *left = pinPage(tree->pager, leftPage);
+  PagedLeaf *right = pinPage(tree->pager, rightPage);
+  PagedEntry leftEntries[PAGED_LEAF];
+  PagedEntry rightEntries[PAGED_LEAF];
+  int leftCount = gatherEntries(left, leftEntries);
+  int rightCount = gatherEntries(right, rightEntries);
+  if (leftCount + rightCount > PAGED_LEAF ||
+      entriesLength(leftEntries, 0, leftCount) + entriesLength(rightEntries, 0, rightCount) > PAGED_VALUES) {
+    unpinPage(tree->pager, leftPage, 0);
+    unpinPage(tree->pager, rightPage, 0);
+    return;
+  }
+
+  // Beide bladeren passen in een pagina, right gaat op in left
+  compactLeaf(left);
+  for (int i = 0; i < rightCount; i++) {
+    appendEntry(left, &rightEntries[i]);
+  }
+  uint32_t after = right->next;
+  unpinPage(tree->pager, rightPage, 0);
+  unpinPage(tree->pager, leftPage, 1);
+  unlinkLeaf(tree, leftPage, after);
+  freePage(tree->pager, rightPage);
+
+  parent->counts[first] += parent->counts[first + 1];
+  parent->counts[first + 1] = 0;
+  combineAggregates(&parent->aggregates[first], &parent->aggregates[first + 1]);
+  removeChild(tree, path, level, first + 1);
+}
+
+/**
+ * Let the only child of the root become the root, as long as the root has one child.
+ */
+static void collapseRoot(PagedTree *tree) {
+  while (tree->height > 0) {
+    PagedInner *root = pinPage(tree->pager, tree->root);
+    uint32_t child = root->children[0];
+    int size = root->node.size;
+    unpinPage(tree->pager, tree->root, 0);
+    if (size > 0) break;
+
+    // De root heeft nog maar een kind, dat wordt de nieuwe root
+    freePage(tree->pager, tree->root);
+    tree->root = child;
+    tree->height--;
+  }
+}
+
+/**
+ * Take a run of entries out of a leaf, their overflow pages are given back.
+ */
+static void removeFromLeaf(PagedTree *tree, PagedLeaf *leaf, int first, int last) {
+  for (int i = first; i < last; i++) {
+    if (leaf->lengths[i] > PAGED_INLINE_DESCRIPTION) {
+      freeOverflow(tree, leaf->locations[i]);
+    }
+  }
+  int moved = leaf->node.size - last;
+  memmove(leaf->keys[first], leaf->keys[last], DATE * moved);
+  memmove(&leaf->lengths[first], &leaf->lengths[last], sizeof(uint32_t) * moved);
+  memmove(&leaf->locations[first], &leaf->locations[last], sizeof(uint32_t) * moved);
+  leaf->node.size -= last - first;
+  if (leaf->node.size == 0) {
+    leaf->used = 0;
+  }
+}
+
+/**
+ * Remove an entry.
+ * @param tree The paged tree where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not in the tree), 1 if succeeded
+ */
+int pagedRemoveEntry(PagedTree *tree, char *date) {
+  PagedPath path;
+  PagedLeaf *leaf = descend(tree, date, &path);
+
+  int index = rankInKeys(leaf->keys, leaf->node.size, date, 0);
+  if (index == leaf->node.size || strcmp(leaf->keys[index], date) != 0) {
+    unpinPage(tree->pager, path.leafPage, 0);
+    releasePath(tree, &path, 0);
+    return 0;
+  }
+
+  // The description goes before the entry, it may be in overflow pages that are given back
+  char *description = strdup(copyDescription(tree, leaf, index));
+  if (description == NULL) {
+    exit(1);
+  }
+  removeFromLeaf(tree, leaf, index, index + 1);
+  updateCounts(tree, &path, -1);
+  removeFromAggregates(tree, &path, leaf, description);
+  free(description);
+  repairLeaf(tree, &path, leaf);
+  releasePath(tree, &path, 1);
+  collapseRoot(tree);
+  return 1;
+}
+
+/**
+ * The amount of entries smaller than (or equal to) a key, summed from the counts on the path to its leaf.
+ * @param tree The paged tree we are counting in
+ * @param search The key
+ * @param inclusive 1 to count an entry on search as well, 0 otherwise
+ * @return The amount of entries
+ */
+static int rank(PagedTree *tree, char *search, int inclusive) {
+  uint32_t page = tree->root;
+  PagedNode *node = pinPage(tree->pager, page);
+  int count = 0;
+  while (!node->leaf) {
+    PagedInner *inner = (PagedInner *) node;
+    int index = rankInKeys(inner->keys, node->size, search, 1);
+    for (int i = 0; i < index; i++) {
+      count += inner->counts[i];
+    }
+    uint32_t child = inner->children[index];
+    unpinPage(tree->pager, page, 0);
+    page = child;
+    node = pinPage(tree->pager, page);
+  }
+  count += rankInKeys(((PagedLeaf *) node)->keys, node->size, search, inclusive);
+  unpinPage(tree->pager, page, 0);
+  return count;
+}
+
+/**
+ * Count the entries between begin and end (both inclusive).
+ * @param tree The paged tree where we will be counting
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The count of entries between begin and end
+ */
+int pagedCountBetweenEntries(PagedTree *tree, char *begin, char *end) {
+  int count = rank(tree, end, 1) - rank(tree, begin, 0);
+  return count > 0 ? count : 0;
+}
+
+/**
+ * Aggregate the entries underneath a page between begin and end (both inclusive). Like aggregateBetweenRecursive,
+ * only the paths to both boundaries are descended, the children in between add the aggregates their parent keeps.
+ * One page is pinned at a time.
+ * @param tree The paged tree we are aggregating in
+ * @param page The current page we are processing
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param fromStart 1 if all entries of the page lie after begin
+ * @param untilEnd 1 if all entries of the page lie before end
+ * @param count The amount of entries, increased
+ * @param aggregate The aggregate, extended
+ */
+static void aggregateRange(PagedTree *tree, uint32_t page, char *begin, char *end, int fromStart, int untilEnd,
+                           int *count, Aggregate *aggregate) {
+  PagedNode *node = pinPage(tree->pager, page);
+  if (node->leaf) {
+    PagedLeaf *leaf = (PagedLeaf *) node;
+    int last = untilEnd ? node->size : rankInKeys(leaf->keys, node->size, end, 1);
+    for (int i = fromStart ? 0 : rankInKeys(leaf->keys, node->size, begin, 0); i < last; i++) {
+      addEntryToAggregate(aggregate, copyDescription(tree, leaf, i));
+      *count += 1;
+    }
+    unpinPage(tree->pager, page, 0);
+    return;
+  }
+
+  PagedInner *inner = (PagedInner *) node;
+  int first = fromStart ? 0 : rankInKeys(inner->keys, node->size, begin, 1); // The child begin is in
+  int last = untilEnd ? node->size : rankInKeys(inner->keys, node->size, end, 1); // The child end is in
+  uint32_t firstChild = inner->children[first];
+  uint32_t lastChild = inner->children[last];
+  for (int i = first + 1; i < last; i++) {
+    *count += inner->counts[i];
+    combineAggregates(aggregate, &inner->aggregates[i]);
+  }
+  unpinPage(tree->pager, page, 0);
+
+  if (first == last) {
+    aggregateRange(tree, firstChild, begin, end, fromStart, untilEnd, count, aggregate);
+  } else if (first < last) {
+    aggregateRange(tree, firstChild, begin, end, fromStart, 1, count, aggregate);
+    aggregateRange(tree, lastChild, begin, end, 1, untilEnd, count, aggregate);
+  }
+}
+
+/**
+ * Aggregate the entries between begin and end (both inclusive), out of the aggregates the inner pages keep for their
+ * children.
+ * @param tree The paged tree where we will be aggregating
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate Set to the aggregate over the entries
+ * @return The amount of entries
+ */
+int pagedAggregateBetweenEntries(PagedTree *tree, char *begin, char *end, Aggregate *aggregate) {
+  int count = 0;
+  emptyAggregate(aggregate);
+  aggregateRange(tree, tree->root, begin, end, 0, 0, &count, aggregate);
+  return count;
+}
+
+/**
+ * Remove all entries from start up to end. We walk the leafs from start on and take out all entries of the range in
+ * a leaf at once, then repair the path to that leaf.
+ * @param tree The paged tree where we want to remove entries
+ * @param start The begin boundary (inclusive), NULL to remove from the first entry on
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if an entry on end should be removed as well, 0 otherwise
+ * @return The amount of entries that were removed
+ */
+int pagedRemoveRange(PagedTree *tree, char *start, char *end, int inclusiveEnd) {
+  PagedPath path;
+  char cursor[DATE];
+  char *from = start;
+  int removed = 0;
+
+  while (1) {
+    PagedLeaf *leaf = descend(tree, from, &path);
+    int first = from == NULL ? 0 : rankInKeys(leaf->keys, leaf->node.size, from, 0);
+    if (first == leaf->node.size) {
+      // Everything in this leaf lies before the range, go on with the next leaf
+      uint32_t next = leaf->next;
+      unpinPage(tree->pager, path.leafPage, 0);
+      releasePath(tree, &path, 0);
+      if (next == PAGE_NONE) break;
+      PagedLeaf *nextLeaf = pinPage(tree->pager, next);
+      memcpy(cursor, nextLeaf->keys[0], DATE);
+      unpinPage(tree->pager, next, 0);
+      from = cursor;
+      continue;
+    }
+
+    int last = first;
+    while (last < leaf->node.size) {
+      int cmp = strcmp(leaf->keys[last], end);
+      if (cmp > 0 || (cmp == 0 && !inclusiveEnd)) break;
+      last++;
+    }
+    if (last == first) {
+      unpinPage(tree->pager, path.leafPage, 0);
+      releasePath(tree, &path, 0);
+      break;
+    }
+
+    removeFromLeaf(tree, leaf, first, last);
+    removed += last - first;
+    updateCounts(tree, &path, first - last);
+    recalculateAggregates(tree, &path, leaf);
+    repairLeaf(tree, &path, leaf);
+    releasePath(tree, &path, 1);
+    collapseRoot(tree);
+  }
+  return removed;
+}
+
+/**
+ * Visit the first or last entries, along the links between the leaf pages. One leaf is pinned at a time.
+ * @param tree The paged tree we are working in
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int pagedEdgeEntries(PagedTree *tree, int last, int count, EntryVisitor visit, void *context) {
+  uint32_t page = tree->root;
+  PagedNode *node = pinPage(tree->pager, page);
+  while (!node->leaf) {
+    uint32_t child = ((PagedInner *) node)->children[last ? node->size : 0];
+    unpinPage(tree->pager, page, 0);
+    page = child;
+    node = pinPage(tree->pager, page);
+  }
+
+  int visited = 0;
+  while (1) {
+    PagedLeaf *leaf = (PagedLeaf *) node;
+    for (int step = 0; step < node->size && visited < count; step++) {
+      int index = last ? node->size - 1 - step : step;
+      visited += visit(leaf->keys[index], copyDescription(tree, leaf, index), context);
+    }
+    uint32_t next = last ? leaf->previous : leaf->next;
+    unpinPage(tree->pager, page, 0);
+    if (visited == count || next == PAGE_NONE) {
+      return visited;
+    }
+    page = next;
+    node = pinPage(tree->pager, page);
+  }
+}
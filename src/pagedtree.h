@@ -0,0 +1,98 @@
+#ifndef BTREE_PAGEDTREE_H
+#define BTREE_PAGEDTREE_H
+
+#include "btree.h"
+#include "pager.h"
+
+#ifndef PAGED_FANOUT
+#define PAGED_FANOUT 48 // maximum amount of children of an inner page, at least 4
+#endif
+#ifndef PAGED_LEAF
+#define PAGED_LEAF 64 // maximum amount of entries in a leaf page, at least 2
+#endif
+#define PAGED_INLINE_DESCRIPTION 256 // longer descriptions are kept in a chain of overflow pages
+#define PAGED_MAX_HEIGHT 32 // the tree can't get higher than this
+#define PAGED_VALUES (PAGE_SIZE - 5 * (int) sizeof(uint32_t) - PAGED_LEAF * (DATE + 2 * (int) sizeof(uint32_t)))
+
+/**
+ * Struct representing the part that inner pages and leaf pages have in common, it is the start of both
+ */
+typedef struct PagedNode {
+    int leaf; // leaf: 1, inner page: 0
+    int size; // leaf: amount of entries, inner page: amount of separator keys (one less than its children)
+} PagedNode;
+
+/**
+ * Struct representing an inner page, it only routes. Separator keys[i] is the smallest key underneath children[i + 1].
+ */
+typedef struct PagedInner {
+    PagedNode node; // The size of the page
+    char keys[PAGED_FANOUT][DATE]; // The separator keys, one spare for splits
+    uint32_t children[PAGED_FANOUT + 1]; // The pages of the children, one spare for splits
+    int counts[PAGED_FANOUT + 1]; // The amount of entries underneath every child
+    Aggregate aggregates[PAGED_FANOUT + 1]; // The aggregates over the entries underneath every child
+} PagedInner;
+
+/**
+ * Struct representing a leaf page. The descriptions are packed in values, a removed entry leaves a hole that is
+ * compacted away when the space is needed.
+ */
+typedef struct PagedLeaf {
+    PagedNode node; // The size of the page
+    uint32_t previous; // The leaf to the left, PAGE_NONE for the first leaf
+    uint32_t next; // The leaf to the right, PAGE_NONE for the last leaf
+    uint32_t used; // The end of the packed descriptions in values
+    char keys[PAGED_LEAF][DATE]; // The keys of the entries
+    uint32_t lengths[PAGED_LEAF]; // The length of every description
+    uint32_t locations[PAGED_LEAF]; // Offset of the description in values, or its first overflow page if it is long
+    char values[PAGED_VALUES]; // The descriptions of at most PAGED_INLINE_DESCRIPTION characters
+} PagedLeaf;
+
+/**
+ * Struct representing a page of a long description
+ */
+typedef struct PagedOverflow {
+    uint32_t next; // The next page of the description, PAGE_NONE for the last one
+    char data[PAGE_SIZE - sizeof(uint32_t)]; // A part of the description
+} PagedOverflow;
+
+/**
+ * Struct representing a B+ tree in a file of pages, the engine behind a BTree created by createPagedBTree. Pages
+ * point to each other by page id, only the pages in the buffer pool of the pager are in memory.
+ */
+struct PagedTree {
+    Pager *pager; // The buffer pool and file of the pages
+    uint32_t root; // The page of the root, a leaf as long as the tree is small
+    int height; // The amount of inner levels above the leafs
+    int size; // The amount of entries in the tree
+    char *description; // Copy of the description pagedGetEntry found last
+    size_t descriptionCapacity; // The allocated length of description
+};
+
+/*
+ * Functions for the creation and free-ing of paged trees
+ */
+BTree *createPagedBTree(char *path, int frames);
+
+PagedTree *createPagedTree(char *path, int frames);
+
+void freePagedTree(PagedTree *tree);
+
+/*
+ * Functions behind the BTree API for paged trees
+ */
+void pagedInsertEntry(PagedTree *tree, char *date, char *description);
+
+char *pagedGetEntry(PagedTree *tree, char *date);
+
+int pagedRemoveEntry(PagedTree *tree, char *date);
+
+int pagedCountBetweenEntries(PagedTree *tree, char *begin, char *end);
+
+int pagedAggregateBetweenEntries(PagedTree *tree, char *begin, char *end, Aggregate *aggregate);
+
+int pagedRemoveRange(PagedTree *tree, char *start, char *end, int inclusiveEnd);
+
+int pagedEdgeEntries(PagedTree *tree, int last, int count, EntryVisitor visit, void *context);
+
+#endif //BTREE_PAGEDTREE_H
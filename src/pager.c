@@ -0,0 +1,245 @@
+#define _GNU_SOURCE // pread and pwrite
+#include "pager.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * The first slot of the hash table a page would be in.
+ */
+static int slotOf(Pager *pager, uint32_t page) {
+  return (int) ((page * 2654435761U) & (uint32_t) pager->tableMask);
+}
+
+/**
+ * Search the frame of a page.
+ * @return The index of the frame or -1 if the page is not in the buffer pool
+ */
+static int searchFrame(Pager *pager, uint32_t page) {
+  for (int slot = slotOf(pager, page); pager->table[slot] >= 0; slot = (slot + 1) & pager->tableMask) {
+    if (pager->frames[pager->table[slot]].page == page) {
+      return pager->table[slot];
+    }
+  }
+  return -1;
+}
+
+/**
+ * Remove the page of a frame from the hash table. The entries after it are shifted back, so the table doesn't need
+ * gravestones.
+ */
+static void removeFromTable(Pager *pager, int frame) {
+  int slot = slotOf(pager, pager->frames[frame].page);
+  while (pager->table[slot] != frame) {
+    slot = (slot + 1) & pager->tableMask;
+  }
+  int next = slot;
+  while (1) {
+    next = (next + 1) & pager->tableMask;
+    if (pager->table[next] < 0) break;
+    int home = slotOf(pager, pager->frames[pager->table[next]].page);
+    // Move the entry back if its home slot doesn't lie in (slot, next]
+    if ((next > slot && (home <= slot || home > next)) || (next < slot && home <= slot && home > next)) {
+      pager->table[slot] = pager->table[next];
+      slot = next;
+    }
+  }
+  pager->table[slot] = -1;
+}
+
+/**
+ * Read or write a whole page of the file.
+ */
+static void transferPage(Pager *pager, uint32_t page, unsigned char *data, int write) {
+  off_t offset = (off_t) page * PAGE_SIZE;
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    ssize_t result = write ? pwrite(pager->fd, data + done, PAGE_SIZE - done, offset + done)
+                           : pread(pager->fd, data + done, PAGE_SIZE - done, offset + done);
+    if (result < 0) {
+      perror(pager->path);
+      exit(1);
+    }
+    if (result == 0) {
+      // Past the end of the file, the page was never written
+      memset(data + done, 0, PAGE_SIZE - done);
+      return;
+    }
+    done += result;
+  }
+}
+
+/**
+ * Open a new, empty file of pages with a buffer pool in front of it. A file that is already at path is overwritten.
+ * @param path The path of the file
+ * @param frameCount The amount of pages the buffer pool holds in memory, at least PAGER_MIN_FRAMES
+ * @return The pager or NULL if the file could not be created
+ */
+Pager *openPager(char *path, int frameCount) {
+  if (frameCount < PAGER_MIN_FRAMES) {
+    frameCount = PAGER_MIN_FRAMES;
+  }
+  Pager *pager = calloc(1, sizeof(Pager));
+  if (pager == NULL) {
+    return NULL;
+  }
+  pager->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (pager->fd < 0) {
+    perror(path);
+    free(pager);
+    return NULL;
+  }
+  pager->path = strdup(path);
+  pager->pageCount = PAGE_NONE + 1;
+  pager->frameCount = frameCount;
+
+  int slots = 1;
+  while (slots < 2 * frameCount) slots *= 2;
+  pager->tableMask = slots - 1;
+  pager->frames = calloc(frameCount, sizeof(PageFrame));
+  pager->table = malloc(sizeof(int) * slots);
+  unsigned char *data = malloc((size_t) frameCount * PAGE_SIZE);
+  if (pager->path == NULL || pager->frames == NULL || pager->table == NULL || data == NULL) {
+    exit(1);
+  }
+  for (int i = 0; i < slots; i++) {
+    pager->table[i] = -1;
+  }
+  for (int i = 0; i < frameCount; i++) {
+    pager->frames[i].page = PAGE_NONE;
+    pager->frames[i].data = &data[(size_t) i * PAGE_SIZE];
+  }
+  return pager;
+}
+
+/**
+ * Close a pager and remove its file, the pages only live as long as the pager.
+ * @param pager The pager we are closing
+ */
+void closePager(Pager *pager) {
+  close(pager->fd);
+  unlink(pager->path);
+  free(pager->frames[0].data);
+  free(pager->frames);
+  free(pager->table);
+  free(pager->freePages);
+  free(pager->path);
+  free(pager);
+}
+
+/**
+ * Get a frame for a page that is not in the buffer pool. The clock hand passes the frames, a frame that was used
+ * since the last pass gets another chance, the first one that wasn't (and isn't pinned) is evicted.
+ * @param pager The pager we are working in
+ * @param page The page that gets the frame
+ * @param read 1 if the page should be read from the file, 0 if its contents don't matter
+ * @return The index of the frame
+ */
+static int loadFrame(Pager *pager, uint32_t page, int read) {
+  int victim = -1;
+  for (int step = 0; step < 2 * pager->frameCount + 1 && victim < 0; step++) {
+    PageFrame *frame = &pager->frames[pager->hand];
+    if (frame->page == PAGE_NONE || (frame->pins == 0 && !frame->referenced)) {
+      victim = pager->hand;
+    } else if (frame->pins == 0) {
+      frame->referenced = 0;
+    }
+    pager->hand = (pager->hand + 1) % pager->frameCount;
+  }
+  if (victim < 0) {
+    fprintf(stderr, "All %i pages of the buffer pool are pinned\n", pager->frameCount);
+    exit(1);
+  }
+
+  PageFrame *frame = &pager->frames[victim];
+  if (frame->page != PAGE_NONE) {
+    if (frame->dirty) {
+      transferPage(pager, frame->page, frame->data, 1);
+    }
+    removeFromTable(pager, victim);
+  }
+
+  frame->page = page;
+  frame->pins = 0;
+  frame->dirty = 0;
+  if (read) {
+    transferPage(pager, page, frame->data, 0);
+  }
+  int slot = slotOf(pager, page);
+  while (pager->table[slot] >= 0) {
+    slot = (slot + 1) & pager->tableMask;
+  }
+  pager->table[slot] = victim;
+  return victim;
+}
+
+/**
+ * Pin a page in the buffer pool, it stays in memory until it is unpinned.
+ * @param pager The pager we are working in
+ * @param page The page we need
+ * @return The contents of the page
+ */
+void *pinPage(Pager *pager, uint32_t page) {
+  int index = searchFrame(pager, page);
+  if (index < 0) {
+    index = loadFrame(pager, page, 1);
+  }
+  PageFrame *frame = &pager->frames[index];
+  frame->pins++;
+  frame->referenced = 1;
+  return frame->data;
+}
+
+/**
+ * Unpin a page, it can be evicted again once nobody has it pinned.
+ * @param pager The pager we are working in
+ * @param page The page we are done with
+ * @param dirty 1 if we changed the page, it is written back before it is evicted
+ */
+void unpinPage(Pager *pager, uint32_t page, int dirty) {
+  PageFrame *frame = &pager->frames[searchFrame(pager, page)];
+  frame->pins--;
+  frame->dirty |= dirty;
+}
+
+/**
+ * Allocate a new page, filled with zeroes and pinned.
+ * @param pager The pager we are working in
+ * @param page Set to the id of the new page
+ * @return The contents of the page
+ */
+void *allocatePage(Pager *pager, uint32_t *page) {
+  *page = pager->freeCount > 0 ? pager->freePages[--pager->freeCount] : pager->pageCount++;
+  int index = searchFrame(pager, *page);
+  if (index < 0) {
+    index = loadFrame(pager, *page, 0);
+  }
+  PageFrame *frame = &pager->frames[index];
+  memset(frame->data, 0, PAGE_SIZE);
+  frame->pins++;
+  frame->referenced = 1;
+  frame->dirty = 1;
+  return frame->data;
+}
+
+/**
+ * Give a page back, it is reused by allocatePage. The page should not be pinned anymore.
+ * @param pager The pager we are working in
+ * @param page The page we don't need anymore
+ */
+void freePage(Pager *pager, uint32_t page) {
+  int index = searchFrame(pager, page);
+  if (index >= 0) {
+    // Its contents don't matter anymore, so it never has to be written back
+    pager->frames[index].dirty = 0;
+    pager->frames[index].referenced = 0;
+  }
+  if (pager->freeCount == pager->freeCapacity) {
+    pager->freeCapacity = pager->freeCapacity > 0 ? pager->freeCapacity * 2 : 64;
+    uint32_t *freePages = realloc(pager->freePages, sizeof(uint32_t) * pager->freeCapacity);
+    if (freePages == NULL) {
+      exit(1);
+    }
+    pager->freePages = freePages;
+  }
+  pager->freePages[pager->freeCount++] = page;
+}
@@ -0,0 +1,62 @@
+#ifndef BTREE_PAGER_H
+#define BTREE_PAGER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PAGE_SIZE 4096 // size of a page in the file and of a frame in the buffer pool
+#define PAGE_NONE 0 // page id that is never used, the first page of the file is left empty
+#ifndef PAGER_FRAMES
+#define PAGER_FRAMES 2048 // default amount of frames in the buffer pool (8 MiB)
+#endif
+#define PAGER_MIN_FRAMES 16 // the buffer pool needs at least this many frames, every level of a tree pins a page
+
+/**
+ * Struct representing a frame of the buffer pool, holding one page of the file
+ */
+typedef struct PageFrame {
+    uint32_t page; // The page in this frame, PAGE_NONE if the frame is empty
+    int pins; // The amount of users of the page, a pinned page is not evicted
+    int dirty; // 1 if the page was changed since it was read or written
+    int referenced; // 1 if the page was used since the clock hand passed it
+    unsigned char *data; // The contents of the page
+} PageFrame;
+
+/**
+ * Struct representing a buffer pool over a file of pages, with CLOCK eviction
+ */
+typedef struct Pager {
+    int fd; // The file the pages live in
+    char *path; // The path of the file, it is removed when the pager is closed
+    uint32_t pageCount; // The amount of pages in the file
+    PageFrame *frames; // The frames of the buffer pool
+    int frameCount; // The amount of frames
+    int hand; // The frame the clock hand points to
+    int *table; // Hash table from page to frame, open addressing, -1 for an empty slot
+    int tableMask; // The amount of slots in table minus one, table has a power of two slots
+    uint32_t *freePages; // Pages that are free to be reused
+    int freeCount; // The amount of free pages
+    int freeCapacity; // The allocated length of freePages
+} Pager;
+
+/*
+ * Functions for the creation and closing of pagers
+ */
+Pager *openPager(char *path, int frameCount);
+
+void closePager(Pager *pager);
+
+/*
+ * Functions for using the pages of a pager
+ */
+void *pinPage(Pager *pager, uint32_t page);
+
+void unpinPage(Pager *pager, uint32_t page, int dirty);
+
+void *allocatePage(Pager *pager, uint32_t *page);
+
+void freePage(Pager *pager, uint32_t page);
+
+#endif //BTREE_PAGER_H
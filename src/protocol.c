@@ -0,0 +1,146 @@
+#include "protocol.h"
+
+// Position of the digits of an ISO date "YYYY-MM-DDThh:mm:ss", in the order of the packed number
+static const int dateDigits[] = {0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18};
+
+#define DATE_DIGITS (int) (sizeof(dateDigits) / sizeof(dateDigits[0]))
+
+/**
+ * Pack an ISO date into the number YYYYMMDDhhmmss. Every field may hold any two (or four) digits.
+ * @param date The ISO date, at least PACKED_DATE_LENGTH characters
+ * @param packed Set to the packed date
+ * @return 1 if succeeded, 0 if date is not an ISO date
+ */
+int packDate(const char *date, uint64_t *packed) {
+  if (date[4] != '-' || date[7] != '-' || date[10] != 'T' || date[13] != ':' || date[16] != ':') {
+    return 0;
+  }
+  uint64_t value = 0;
+  for (int i = 0; i < DATE_DIGITS; i++) {
+    char digit = date[dateDigits[i]];
+    if (digit < '0' || digit > '9') {
+      return 0;
+    }
+    value = value * 10 + (digit - '0');
+  }
+  *packed = value;
+  return 1;
+}
+
+/**
+ * Unpack a date into its ISO string.
+ * @param packed The packed date
+ * @param date Filled with the ISO date and a '\0', at least PACKED_DATE_LENGTH + 1 characters
+ */
+void unpackDate(uint64_t packed, char *date) {
+  memcpy(date, "0000-00-00T00:00:00", PACKED_DATE_LENGTH + 1);
+  for (int i = DATE_DIGITS - 1; i >= 0; i--) {
+    date[dateDigits[i]] = (char) ('0' + packed % 10);
+    packed /= 10;
+  }
+}
+
+/**
+ * Read a little-endian u32.
+ */
+uint32_t readU32(const unsigned char *bytes) {
+  return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+/**
+ * Read a little-endian u64.
+ */
+uint64_t readU64(const unsigned char *bytes) {
+  return (uint64_t) readU32(bytes) | (uint64_t) readU32(&bytes[4]) << 32;
+}
+
+/**
+ * Write a little-endian u32.
+ */
+void writeU32(unsigned char *bytes, uint32_t value) {
+  bytes[0] = value;
+  bytes[1] = value >> 8;
+  bytes[2] = value >> 16;
+  bytes[3] = value >> 24;
+}
+
+/**
+ * Write a little-endian u64.
+ */
+void writeU64(unsigned char *bytes, uint64_t value) {
+  writeU32(bytes, (uint32_t) value);
+  writeU32(&bytes[4], (uint32_t) (value >> 32));
+}
+
+/**
+ * Read a little-endian f64.
+ */
+double readF64(const unsigned char *bytes) {
+  uint64_t bits = readU64(bytes);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * Write a little-endian f64.
+ */
+void writeF64(unsigned char *bytes, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  writeU64(bytes, bits);
+}
+
+/**
+ * Print the text answer of $: the amount of entries, the length of their descriptions, the amount of entries with a
+ * numeric payload and the sum, minimum and maximum of the payloads ("?" if there are none).
+ */
+void printAggregate(FILE *out, uint32_t count, uint64_t bytes, uint32_t valued, double sum, double min, double max) {
+  fprintf(out, "%u %llu %u %.15g", count, (unsigned long long) bytes, valued, sum);
+  if (valued > 0) {
+    fprintf(out, " %.15g %.15g\n", min, max);
+  } else {
+    fprintf(out, " ? ?\n");
+  }
+}
+
+/**
+ * The length of a command in a frame.
+ * @param command The start of the command
+ * @param available The amount of bytes left in the frame
+ * @return The length of the command in bytes, -1 if it is invalid or doesn't fit in the frame
+ */
+int commandLength(const unsigned char *command, size_t available) {
+  size_t length;
+  switch (available > 0 ? command[0] : 0) {
+    case '+':
+      if (available < 13) return -1;
+      length = 13 + (size_t) readU32(&command[9]);
+      break;
+    case '-':
+    case '?':
+    case '<':
+      length = 9;
+      break;
+    case '#':
+    case '/':
+    case '$':
+      length = 17;
+      break;
+    case '%':
+    case '*':
+      length = 1;
+      break;
+    case '[':
+    case ']':
+      length = 5;
+      break;
+    case '@':
+      if (available < 5) return -1;
+      length = 5 + (size_t) readU32(&command[1]);
+      break;
+    default:
+      return -1;
+  }
+  return length <= available && length <= INT32_MAX ? (int) length : -1;
+}
@@ -0,0 +1,64 @@
+#ifndef BTREE_PROTOCOL_H
+#define BTREE_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The binary protocol, all integers are little-endian.
+ *
+ * Frame:   u32 length (of the rest of the frame) | u32 count | count commands or answers
+ * Command: u8 '+' | u64 date | u32 description length | description
+ *          u8 '-', '?' or '<' | u64 date
+ *          u8 '#', '/' or '$' | u64 date | u64 date
+ *          u8 '%' or '*'
+ *          u8 '[' or ']' | u32 count
+ *          u8 '@' | u32 name length | name
+ * Answer:  u8 '!' | u32 description length | description  (? found the entry)
+ *          u8 '?'  (? or - didn't find the entry, % on a tree without fill, [ or ] on an empty tree, @ couldn't
+ *                  write the snapshot)
+ *          u8 '-'  (- removed the entry)
+ *          u8 '#' | u32 amount  (answer of #, / and <, of % with the fill percentage and of @ with the amount of
+ *                  entries in the snapshot)
+ *          u8 '[' | u32 amount | amount times (u64 date | u32 description length | description)  ([ or ] found entries)
+ *          u8 '$' | u32 amount | u64 bytes | u32 valued | f64 sum | f64 min | f64 max  (answer of $)
+ *
+ * A date is packed as the decimal number YYYYMMDDhhmmss, so packed dates compare like the ISO strings. A frame
+ * without commands ends the session, like an empty line in the text protocol.
+ */
+#define FRAME_LENGTH 4 // the length in front of every frame
+#define FRAME_HEADER 8 // length and count of a frame
+#define PACKED_DATE_LENGTH 19 // length of the ISO date a packed date stands for
+
+/*
+ * Functions for packing dates
+ */
+int packDate(const char *date, uint64_t *packed);
+
+void unpackDate(uint64_t packed, char *date);
+
+/*
+ * Functions for reading and writing the little-endian numbers of frames
+ */
+uint32_t readU32(const unsigned char *bytes);
+
+uint64_t readU64(const unsigned char *bytes);
+
+void writeU32(unsigned char *bytes, uint32_t value);
+
+void writeU64(unsigned char *bytes, uint64_t value);
+
+double readF64(const unsigned char *bytes);
+
+void writeF64(unsigned char *bytes, double value);
+
+int commandLength(const unsigned char *command, size_t available);
+
+/*
+ * Functions for the text form of answers
+ */
+void printAggregate(FILE *out, uint32_t count, uint64_t bytes, uint32_t valued, double sum, double min, double max);
+
+#endif //BTREE_PROTOCOL_H
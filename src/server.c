@@ -0,0 +1,551 @@
+#define _GNU_SOURCE // accept4
+#include "server.h"
+#include "command.h"
+#include "protocol.h"
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static volatile sig_atomic_t stopping = 0;
+
+/**
+ * Signal handler for SIGINT and SIGTERM, the event loop stops after the current events.
+ */
+static void stopServer(int number) {
+  (void) number;
+  stopping = 1;
+}
+
+/**
+ * Accept all clients waiting on the listening socket.
+ * @param epoll The epoll instance the clients are added to
+ * @param listener The listening socket
+ * @param connections Pointer to the first connection of the server
+ * @param binary 1 if the clients speak the binary protocol, 0 for the line protocol
+ */
+static void acceptConnections(int epoll, int listener, Connection **connections, int binary) {
+  int fd;
+  while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    Connection *connection = calloc(1, sizeof(Connection));
+    if (connection == NULL) {
+      close(fd);
+      continue;
+    }
+    connection->fd = fd;
+    connection->binary = binary;
+
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+      close(fd);
+      free(connection);
+      continue;
+    }
+    connection->next = *connections;
+    if (*connections != NULL) {
+      (*connections)->previous = connection;
+    }
+    *connections = connection;
+  }
+}
+
+/**
+ * Close a connection and free it.
+ * @param connection The connection we are closing
+ * @param connections Pointer to the first connection of the server
+ */
+static void closeConnection(Connection *connection, Connection **connections) {
+  if (connection->previous != NULL) {
+    connection->previous->next = connection->next;
+  } else {
+    *connections = connection->next;
+  }
+  if (connection->next != NULL) {
+    connection->next->previous = connection->previous;
+  }
+  close(connection->fd); // also removes it from the epoll instance
+  free(connection->input);
+  free(connection->output);
+  free(connection);
+}
+
+/**
+ * Execute all complete commands in the input of a connection, the answers are written to out. An incomplete command
+ * stays in the input until the rest of it is read.
+ * @param tree The tree the commands are executed on
+ * @param connection The connection whose commands we are executing
+ * @param out Where the answers are written to
+ */
+static void executeCommands(BTree *tree, Connection *connection, FILE *out) {
+  size_t start = 0;
+  char *end;
+  while (!connection->closing &&
+         (end = memchr(&connection->input[start], '\n', connection->inputLength - start)) != NULL) {
+    // executeCommand wants the command as a string, including its line end
+    size_t next = end - connection->input + 1;
+    char saved = connection->input[next];
+    connection->input[next] = '\0';
+    int status = executeCommand(tree, &connection->input[start], out);
+    connection->input[next] = saved;
+    start = next;
+
+    if (status == COMMAND_INVALID) {
+      fprintf(out, "This is an invalid command. The connection will now close\n");
+    }
+    if (status != COMMAND_DONE) {
+      connection->closing = 1;
+    }
+  }
+
+  if (connection->closing) {
+    connection->inputLength = 0;
+  } else {
+    memmove(connection->input, &connection->input[start], connection->inputLength - start);
+    connection->inputLength -= start;
+  }
+}
+
+/**
+ * Execute all complete frames in the input of a connection, the answer frames are written to out. An incomplete
+ * frame stays in the input until the rest of it is read.
+ * @param tree The tree the commands are executed on
+ * @param connection The connection whose frames we are executing
+ * @param out Where the answers are written to
+ */
+static void executeFrames(BTree *tree, Connection *connection, FILE *out) {
+  size_t start = 0;
+  while (!connection->closing && connection->inputLength - start >= FRAME_LENGTH) {
+    size_t length = readU32((unsigned char *) &connection->input[start]);
+    if (connection->inputLength - start - FRAME_LENGTH < length) break;
+
+    int status = executeFrame(tree, (unsigned char *) &connection->input[start + FRAME_LENGTH], length, out);
+    start += FRAME_LENGTH + length;
+    if (status != COMMAND_DONE) {
+      connection->closing = 1;
+    }
+  }
+
+  if (connection->closing) {
+    connection->inputLength = 0;
+  } else {
+    memmove(connection->input, &connection->input[start], connection->inputLength - start);
+    connection->inputLength -= start;
+  }
+}
+
+/**
+ * Send as much of the pending answers of a connection as the socket takes.
+ * @param connection The connection we are sending to
+ * @return 1 if all answers are sent, 0 if some are pending, -1 if the client is gone
+ */
+static int sendAnswers(Connection *connection) {
+  while (connection->outputSent < connection->outputLength) {
+    ssize_t sent = send(connection->fd, &connection->output[connection->outputSent],
+                        connection->outputLength - connection->outputSent, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    connection->outputSent += sent;
+  }
+  connection->outputLength = 0;
+  connection->outputSent = 0;
+  return 1;
+}
+
+/**
+ * Read a batch of commands of a connection into its input.
+ * @param connection The connection we are reading from
+ * @return 1 if the connection is still open, 0 if it should be closed
+ */
+static int readCommands(Connection *connection) {
+  // One spare byte, executeCommands terminates every command with a '\0' right after its line end
+  if (connection->inputCapacity - connection->inputLength < SERVER_READ + 1) {
+    size_t capacity = connection->inputLength + SERVER_READ + 1;
+    char *input = realloc(connection->input, capacity);
+    if (input == NULL) {
+      return 0;
+    }
+    connection->input = input;
+    connection->inputCapacity = capacity;
+  }
+
+  ssize_t length = read(connection->fd, &connection->input[connection->inputLength], SERVER_READ);
+  if (length < 0) {
+    return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+  connection->inputLength += length;
+  if (length == 0) {
+    connection->ended = 1;
+    if (connection->inputLength > 0 && !connection->binary) {
+      // The client is done, the last command doesn't need a line end (like the last line on stdin)
+      connection->input[connection->inputLength++] = '\n';
+    }
+  }
+  return 1;
+}
+
+/**
+ * Execute the complete commands (or frames) in the input of a connection and add their answers to its output, so
+ * they are sent at once.
+ * @param tree The tree the commands are executed on
+ * @param connection The connection whose batch we are executing
+ * @return 1 if the connection is still open, 0 if it should be closed
+ */
+static int executeBatch(BTree *tree, Connection *connection) {
+  char *answers = NULL;
+  size_t answersLength = 0;
+  FILE *out = open_memstream(&answers, &answersLength);
+  if (out == NULL) {
+    return 0;
+  }
+  if (connection->binary) {
+    executeFrames(tree, connection, out);
+  } else {
+    executeCommands(tree, connection, out);
+  }
+  fclose(out);
+  if (connection->ended) {
+    connection->closing = 1;
+  }
+
+  if (answersLength > 0) {
+    if (connection->outputLength == 0) {
+      free(connection->output);
+      connection->output = answers;
+      connection->outputLength = answersLength;
+      return 1;
+    }
+    char *output = realloc(connection->output, connection->outputLength + answersLength);
+    if (output == NULL) {
+      free(answers);
+      return 0;
+    }
+    memcpy(&output[connection->outputLength], answers, answersLength);
+    connection->output = output;
+    connection->outputLength += answersLength;
+  }
+  free(answers);
+  return 1;
+}
+
+/**
+ * The loop of a worker thread, which executes the queued batches until the workers stop and the queue is empty.
+ * @param argument The ServerWorkers the thread belongs to
+ * @return NULL
+ */
+static void *executeBatches(void *argument) {
+  ServerWorkers *workers = argument;
+
+  pthread_mutex_lock(&workers->lock);
+  while (1) {
+    while (!workers->stopping && workers->queue == NULL) {
+      pthread_cond_wait(&workers->ready, &workers->lock);
+    }
+    if (workers->queue == NULL) break;
+
+    Connection *connection = workers->queue;
+    workers->queue = connection->nextBatch;
+    pthread_mutex_unlock(&workers->lock);
+
+    connection->failed = !executeBatch(workers->tree, connection);
+
+    pthread_mutex_lock(&workers->lock);
+    connection->nextBatch = workers->finished;
+    workers->finished = connection;
+    uint64_t one = 1;
+    if (write(workers->wakeup, &one, sizeof(one)) < 0) {
+      // The counter is full, so the event loop is woken up already
+    }
+  }
+  pthread_mutex_unlock(&workers->lock);
+  return NULL;
+}
+
+/**
+ * Stop the worker threads of a server once they executed the queued batches, and free them.
+ * @param workers The workers we are stopping
+ */
+static void stopWorkers(ServerWorkers *workers) {
+  pthread_mutex_lock(&workers->lock);
+  workers->stopping = 1;
+  pthread_cond_broadcast(&workers->ready);
+  pthread_mutex_unlock(&workers->lock);
+  for (int i = 0; i < workers->started; i++) {
+    pthread_join(workers->threads[i], NULL);
+  }
+  close(workers->wakeup);
+  pthread_mutex_destroy(&workers->lock);
+  pthread_cond_destroy(&workers->ready);
+  free(workers);
+}
+
+/**
+ * Start the worker threads of a server on a sharded tree.
+ * @param tree The tree the batches are executed on
+ * @return The workers or NULL if no thread could be started, the event loop executes the batches itself then
+ */
+static ServerWorkers *startWorkers(BTree *tree) {
+  ServerWorkers *workers = calloc(1, sizeof(ServerWorkers));
+  if (workers == NULL) {
+    return NULL;
+  }
+  workers->tree = tree;
+  workers->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (workers->wakeup < 0) {
+    free(workers);
+    return NULL;
+  }
+  pthread_mutex_init(&workers->lock, NULL);
+  pthread_cond_init(&workers->ready, NULL);
+  while (workers->started < SERVER_WORKERS &&
+         pthread_create(&workers->threads[workers->started], NULL, executeBatches, workers) == 0) {
+    workers->started++;
+  }
+  if (workers->started == 0) {
+    stopWorkers(workers);
+    return NULL;
+  }
+  return workers;
+}
+
+/**
+ * Hand the batch of a connection to the workers.
+ * @param workers The workers of the server
+ * @param connection The connection with the batch, out of the epoll instance until the batch is executed
+ */
+static void queueBatch(ServerWorkers *workers, Connection *connection) {
+  pthread_mutex_lock(&workers->lock);
+  connection->nextBatch = NULL;
+  if (workers->queue == NULL) {
+    workers->queue = connection;
+  } else {
+    workers->queueEnd->nextBatch = connection;
+  }
+  workers->queueEnd = connection;
+  pthread_cond_signal(&workers->ready);
+  pthread_mutex_unlock(&workers->lock);
+}
+
+/**
+ * Send the pending answers of a connection and decide whether we wait to read from it or to write to it, or close
+ * it.
+ * @param epoll The epoll instance of the server
+ * @param connection The connection we are answering
+ * @param connections Pointer to the first connection of the server
+ * @param open 1 if the connection is still open, 0 if it should be closed
+ */
+static void answerConnection(int epoll, Connection *connection, Connection **connections, int open) {
+  int sent = open ? sendAnswers(connection) : -1;
+  if (sent < 0 || (sent == 1 && connection->closing)) {
+    closeConnection(connection, connections);
+    return;
+  }
+
+  // While answers are pending we stop reading from the client, so a client that doesn't read can't make us
+  // buffer an unlimited amount of answers
+  if (connection->waiting != !sent) {
+    connection->waiting = !sent;
+    struct epoll_event event = {.events = sent ? EPOLLIN : EPOLLOUT, .data.ptr = connection};
+    epoll_ctl(epoll, EPOLL_CTL_MOD, connection->fd, &event);
+  }
+}
+
+/**
+ * Take back the connections whose batch the workers executed, put them back in the epoll instance and answer them.
+ * @param epoll The epoll instance of the server
+ * @param workers The workers of the server
+ * @param connections Pointer to the first connection of the server
+ */
+static void answerBatches(int epoll, ServerWorkers *workers, Connection **connections) {
+  uint64_t count;
+  if (read(workers->wakeup, &count, sizeof(count)) < 0) {
+    // Nothing was signalled, another wakeup took the finished batches already
+  }
+  pthread_mutex_lock(&workers->lock);
+  Connection *finished = workers->finished;
+  workers->finished = NULL;
+  pthread_mutex_unlock(&workers->lock);
+
+  while (finished != NULL) {
+    Connection *connection = finished;
+    finished = connection->nextBatch;
+    connection->waiting = 0;
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+    epoll_ctl(epoll, EPOLL_CTL_ADD, connection->fd, &event);
+    answerConnection(epoll, connection, connections, !connection->failed);
+  }
+}
+
+/**
+ * Remove a socket that a server left behind at a path, so we can bind to it. Nothing else is removed: the path may
+ * not exist, but if it does it should be a socket that no server accepts connections on anymore.
+ * @param path The path of the socket
+ * @param address The address of the path
+ * @return 1 if the path is free now, 0 otherwise (with an error on stderr)
+ */
+static int removeStaleSocket(char *path, struct sockaddr_un *address) {
+  struct stat status;
+  if (lstat(path, &status) < 0) {
+    if (errno == ENOENT) {
+      return 1;
+    }
+    perror(path);
+    return 0;
+  }
+  if (!S_ISSOCK(status.st_mode)) {
+    fprintf(stderr, "%s exists and is not a socket\n", path);
+    return 0;
+  }
+
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    perror("socket");
+    return 0;
+  }
+  if (connect(probe, (struct sockaddr *) address, sizeof(*address)) == 0) {
+    close(probe);
+    fprintf(stderr, "%s is in use by another server\n", path);
+    return 0;
+  }
+  // Nobody listens on a socket whose server stopped, connecting to it is refused
+  int stale = errno == ECONNREFUSED || errno == ENOENT;
+  if (!stale) {
+    perror(path);
+  }
+  close(probe);
+  if (!stale) {
+    return 0;
+  }
+  if (unlink(path) < 0 && errno != ENOENT) {
+    perror(path);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * Create the listening Unix domain socket. A socket that a stopped server left at path is replaced, anything else at
+ * path is an error.
+ * @param path The path of the socket
+ * @return The socket or -1 if it could not be created
+ */
+static int createListener(char *path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "The socket path %s is too long\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listener < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (!removeStaleSocket(path, &address)) {
+    close(listener);
+    return -1;
+  }
+  if (bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, SERVER_BACKLOG) < 0) {
+    perror(path);
+    close(listener);
+    return -1;
+  }
+  return listener;
+}
+
+/**
+ * Keep the tree resident and serve the line protocol (or the binary protocol) to the clients of a Unix domain socket,
+ * until we get SIGINT or SIGTERM. Clients can send many commands without waiting for the answers, all commands in one
+ * read are executed in order and answered with one write. On a sharded tree the batches go to SERVER_WORKERS worker
+ * threads, so the batches of different clients run at the same time and only wait on each other for the same shard.
+ * The other engines aren't safe to use from many threads, the event loop executes their batches one after the other.
+ * @param tree The tree the commands are executed on
+ * @param path The path of the socket
+ * @param binary 1 if the clients speak the binary protocol, 0 for the line protocol
+ * @return the exit code of the program
+ */
+int runServer(BTree *tree, char *path, int binary) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stopServer; // no SA_RESTART, epoll_wait should return on the signal
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  int listener = createListener(path);
+  if (listener < 0) {
+    return 1;
+  }
+  int epoll = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event listenEvent = {.events = EPOLLIN, .data.ptr = NULL};
+  if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listenEvent) < 0) {
+    perror("epoll");
+    close(listener);
+    unlink(path);
+    return 1;
+  }
+
+  ServerWorkers *workers = tree->shards != NULL ? startWorkers(tree) : NULL;
+  struct epoll_event wakeupEvent = {.events = EPOLLIN, .data.ptr = workers};
+  if (workers != NULL && epoll_ctl(epoll, EPOLL_CTL_ADD, workers->wakeup, &wakeupEvent) < 0) {
+    stopWorkers(workers);
+    workers = NULL;
+  }
+
+  Connection *connections = NULL;
+  struct epoll_event events[SERVER_EVENTS];
+  int status = 0;
+  while (!stopping) {
+    int count = epoll_wait(epoll, events, SERVER_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      status = 1;
+      break;
+    }
+
+    for (int i = 0; i < count; i++) {
+      if (workers != NULL && events[i].data.ptr == workers) {
+        answerBatches(epoll, workers, &connections);
+        continue;
+      }
+      Connection *connection = events[i].data.ptr;
+      if (connection == NULL) {
+        acceptConnections(epoll, listener, &connections, binary);
+        continue;
+      }
+
+      int open = 1;
+      if (connection->outputLength == 0 && !connection->closing) {
+        open = readCommands(connection);
+        if (open && workers != NULL) {
+          // A worker executes the batch, meanwhile the connection is out of the epoll instance
+          epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+          queueBatch(workers, connection);
+          continue;
+        }
+        open = open && executeBatch(tree, connection);
+      }
+      answerConnection(epoll, connection, &connections, open);
+    }
+  }
+
+  if (workers != NULL) {
+    stopWorkers(workers);
+  }
+  while (connections != NULL) {
+    closeConnection(connections, &connections);
+  }
+  close(epoll);
+  close(listener);
+  unlink(path);
+  return status;
+}
@@ -0,0 +1,62 @@
+#ifndef BTREE_SERVER_H
+#define BTREE_SERVER_H
+
+#include "btree.h"
+#include <pthread.h>
+
+#define SERVER_BACKLOG 128 // amount of connections waiting to be accepted
+#define SERVER_EVENTS 64 // amount of events handled per epoll_wait
+#ifndef SERVER_READ
+#define SERVER_READ 65536 // amount of bytes read from a client at once, all commands in it are answered as one batch
+#endif
+#ifndef SERVER_WORKERS
+#define SERVER_WORKERS 4 // threads executing the batches of the clients of a sharded tree, each locks its own shards
+#endif
+
+typedef struct Connection Connection;
+
+/**
+ * Struct representing a client connected to the server
+ */
+struct Connection {
+    int fd; // The socket of the client
+    char *input; // Bytes read from the client that are not executed yet (an incomplete command)
+    size_t inputLength; // The amount of bytes in input
+    size_t inputCapacity; // The allocated length of input
+    char *output; // Answers that are not sent to the client yet
+    size_t outputLength; // The amount of bytes in output
+    size_t outputSent; // The amount of bytes of output that are already sent
+    int binary; // 1 if the client speaks the binary protocol, 0 for the line protocol
+    int closing; // 1 if the connection is closed once all answers are sent
+    int waiting; // 1 if we wait until the socket takes the pending answers, instead of reading new commands
+    int ended; // 1 if the client closed its side, the connection closes once the last batch is answered
+    int failed; // 1 if the worker ran out of memory for the answers, the connection is closed
+    Connection *previous; // The previous connection of the server
+    Connection *next; // The next connection of the server
+    Connection *nextBatch; // The next connection in the queue of the workers or in their list of finished batches
+};
+
+/**
+ * Struct representing the worker threads of a server on a sharded tree. The event loop reads the batches and sends
+ * the answers, the workers execute the batches, so commands of different clients on different shards run at the
+ * same time.
+ */
+typedef struct ServerWorkers {
+    BTree *tree; // The tree the batches are executed on
+    pthread_t threads[SERVER_WORKERS]; // The worker threads
+    int started; // The amount of threads that are running
+    int stopping; // 1 if the workers should stop once the queue is empty
+    pthread_mutex_t lock; // Lock protecting the queue, finished and stopping
+    pthread_cond_t ready; // Signalled when a batch is queued or the workers should stop
+    Connection *queue; // The connections with a batch to execute, the first one is the oldest
+    Connection *queueEnd; // The last connection of queue
+    Connection *finished; // The connections whose batch is executed, to be answered by the event loop
+    int wakeup; // eventfd the workers signal when they finished a batch, the event loop waits on it
+} ServerWorkers;
+
+/*
+ * Functions for the server mode
+ */
+int runServer(BTree *tree, char *path, int binary);
+
+#endif //BTREE_SERVER_H
@@ -0,0 +1,817 @@
+#include "shard.h"
+#include "buffer.h"
+#include "filter.h"
+#include "aggregate.h"
+
+/**
+ * Compare the range of a shard with a date.
+ * @param shard The shard we are comparing
+ * @param date The date we are comparing
+ * @return < 0 if the shard lies before date, 0 if date lies in the shard, > 0 if the shard lies after date
+ */
+static int compareShard(Shard *shard, char *date) {
+  return strncmp(shard->prefix, date, shard->prefixLength);
+}
+
+/**
+ * Search the shard a date belongs to.
+ * @param set The shards we are searching in
+ * @param date The date we are searching
+ * @param insertAt The index where a new shard for date should be inserted if there is none
+ * @return The index of the shard or -1 if there is no shard for date yet
+ */
+static int searchShard(ShardSet *set, char *date, int *insertAt) {
+  int start = 0;
+  int stop = set->size - 1;
+
+  while (start <= stop) {
+    int mid = (start + stop) / 2;
+    int cmp = compareShard(set->shards[mid], date);
+    if (cmp < 0) {
+      start = mid + 1;
+    } else if (cmp > 0) {
+      stop = mid - 1;
+    } else {
+      return mid;
+    }
+  }
+  if (insertAt != NULL) *insertAt = start;
+  return -1;
+}
+
+/**
+ * Determine the prefix length of a new shard so it doesn't overlap its neighbours.
+ * @param set The shards the new shard will be part of
+ * @param date The date the new shard is created for
+ * @param insertAt The index where the new shard will be inserted
+ * @return The smallest SHARD_* level that keeps the shards disjoint
+ */
+static int shardLevel(ShardSet *set, char *date, int insertAt) {
+  int common = 0;
+  for (int i = insertAt - 1; i <= insertAt; i++) {
+    if (i < 0 || i >= set->size) continue;
+    int length = 0;
+    while (length < set->shards[i]->prefixLength && set->shards[i]->prefix[length] == date[length]) {
+      length++;
+    }
+    if (length > common) common = length;
+  }
+  if (common < SHARD_YEAR) return SHARD_YEAR;
+  if (common < SHARD_MONTH) return SHARD_MONTH;
+  if (common < SHARD_DAY) return SHARD_DAY;
+  return SHARD_HOUR;
+}
+
+/**
+ * The next (finer) level after a SHARD_* level.
+ */
+static int nextLevel(int level) {
+  return level == SHARD_YEAR ? SHARD_MONTH : level == SHARD_MONTH ? SHARD_DAY : SHARD_HOUR;
+}
+
+/**
+ * The previous (coarser) level before a SHARD_* level.
+ */
+static int previousLevel(int level) {
+  return level == SHARD_HOUR ? SHARD_DAY : level == SHARD_DAY ? SHARD_MONTH : SHARD_YEAR;
+}
+
+/**
+ * Create a new, empty shard, with the modes of the directory.
+ * @param set The shards the shard will belong to
+ * @param date A date the shard should contain
+ * @param prefixLength The SHARD_* level of the shard
+ * @return The created shard or NULL if we are out of memory
+ */
+static Shard *createShard(ShardSet *set, char *date, int prefixLength) {
+  Shard *shard = malloc(sizeof(Shard));
+  if (shard == NULL) {
+    return NULL;
+  }
+  shard->tree = createBTree();
+  if (shard->tree == NULL) {
+    free(shard);
+    return NULL;
+  }
+  shard->tree->buffered = set->buffered;
+  if (set->filtered) {
+    enableFilter(shard->tree);
+  }
+  memcpy(shard->prefix, date, prefixLength);
+  shard->prefix[prefixLength] = '\0';
+  shard->prefixLength = prefixLength;
+  pthread_mutex_init(&shard->lock, NULL);
+  return shard;
+}
+
+/**
+ * The amount of live entries in a shard, kept in the root of its tree. Buffered writes are applied first, so with
+ * -b this is only O(1) for a shard without pending messages.
+ * The caller should hold the lock of the shard (or the directory write lock).
+ * @param shard The shard we are counting
+ * @return The amount of entries in the shard
+ */
+static int shardTotal(Shard *shard) {
+  if (shard->tree->buffered) {
+    flushRange(shard->tree, NULL, NULL);
+  }
+  return shard->tree->root->recursiveSize;
+}
+
+/**
+ * The most live entries a shard can have, without applying its buffered writes: the entries in its nodes and one for
+ * every pending message. Without -b this is the total of the shard.
+ * @param shard The shard we are counting
+ * @return The upper bound of the amount of entries in the shard
+ */
+static int shardUpperBound(Shard *shard) {
+  return shard->tree->root->recursiveSize + shard->tree->root->pendingMessages;
+}
+
+/**
+ * Free a shard and all of its entries.
+ * @param shard The shard we want to free
+ */
+static void freeShard(Shard *shard) {
+  freeBTree(shard->tree);
+  pthread_mutex_destroy(&shard->lock);
+  free(shard);
+}
+
+/**
+ * Take a shard out of use without free-ing its entries yet, they are handed over to the detached nodes of the
+ * directory. The caller should hold the directory write lock.
+ * @param set The shards the shard belonged to
+ * @param shard The shard we are retiring
+ */
+static void retireShard(ShardSet *set, Shard *shard) {
+  pthread_mutex_lock(&set->detachedLock);
+  detachNode(NULL, &set->detached, shard->tree->root);
+  for (int i = 0; i < shard->tree->detached.size; i++) {
+    detachNode(NULL, &set->detached, shard->tree->detached.nodes[i]);
+  }
+  pthread_mutex_unlock(&set->detachedLock);
+  free(shard->tree->detached.nodes);
+  freeFilter(shard->tree->filter);
+  free(shard->tree);
+  pthread_mutex_destroy(&shard->lock);
+  free(shard);
+}
+
+/**
+ * Insert a shard in a sorted list of shards.
+ * @param shards Pointer to the list of shards
+ * @param size Pointer to the amount of shards in the list
+ * @param capacity Pointer to the allocated length of the list
+ * @param index The index where the shard should be placed
+ * @param shard The shard we are inserting
+ */
+static void insertShard(Shard ***shards, int *size, int *capacity, int index, Shard *shard) {
+  if (*size == *capacity) {
+    int newCapacity = *capacity > 0 ? *capacity * 2 : 16;
+    Shard **newShards = realloc(*shards, sizeof(Shard *) * newCapacity);
+    if (newShards == NULL) {
+      exit(1);
+    }
+    *shards = newShards;
+    *capacity = newCapacity;
+  }
+  memmove(&(*shards)[index + 1], &(*shards)[index], sizeof(Shard *) * (*size - index));
+  (*shards)[index] = shard;
+  (*size)++;
+}
+
+/**
+ * Move all entries underneath a node into shards of a given level, in key order. Gravestones are dropped and the
+ * nodes are freed, the entries themselves are reused.
+ * @param set The shards the new shards will belong to
+ * @param node The node we are emptying
+ * @param prefixLength The SHARD_* level of the shards we are filling
+ * @param shards Pointer to the list of shards we are filling, new shards are appended
+ * @param size Pointer to the amount of shards in the list
+ * @param capacity Pointer to the allocated length of the list
+ */
+static void redistributeNode(ShardSet *set, BTreeNode *node, int prefixLength, Shard ***shards, int *size,
+                             int *capacity) {
+  for (int i = 0; i <= node->size; i++) {
+    if (!node->leaf) {
+      redistributeNode(set, node->childNodes[i], prefixLength, shards, size, capacity);
+    }
+    if (i == node->size) break;
+
+    if (node->descriptionValues[i] == NULL) {
+      free(node->dateKeys[i]);
+      continue;
+    }
+    Shard *last = *size > 0 ? (*shards)[*size - 1] : NULL;
+    if (last == NULL || compareShard(last, node->dateKeys[i]) != 0) {
+      last = createShard(set, node->dateKeys[i], prefixLength);
+      if (last == NULL) {
+        exit(1);
+      }
+      insertShard(shards, size, capacity, *size, last);
+    }
+    insertEntry(last->tree, node->dateKeys[i], node->descriptionValues[i]);
+  }
+  releaseNode(node);
+}
+
+/**
+ * Fill shards with sorted entries at once, the way buildTree fills a tree. The entries that share their prefix on a
+ * level go to one shard, unless there are too many of them for one shard: then they are spread over the next level.
+ * @param set The shards, the new shards are added after the others
+ * @param entries The live entries in strictly increasing order, the shards take the strings over
+ * @param count The amount of entries
+ * @param prefixLength The SHARD_* level we are filling
+ */
+static void buildShardLevel(ShardSet *set, CompactedEntry *entries, int count, int prefixLength) {
+  int first = 0;
+  while (first < count) {
+    int last = first + 1;
+    while (last < count && strncmp(entries[last].date, entries[first].date, prefixLength) == 0) {
+      last++;
+    }
+    if (last - first > SHARD_SPLIT_SIZE && prefixLength < SHARD_HOUR) {
+      buildShardLevel(set, &entries[first], last - first, nextLevel(prefixLength));
+    } else {
+      Shard *shard = createShard(set, entries[first].date, prefixLength);
+      CompactedEntry *slice = malloc(sizeof(CompactedEntry) * (last - first));
+      if (shard == NULL || slice == NULL) {
+        exit(1);
+      }
+      memcpy(slice, &entries[first], sizeof(CompactedEntry) * (last - first));
+      buildTree(shard->tree, slice, last - first);
+      if (shard->tree->filter != NULL) {
+        rebuildFilter(shard->tree);
+      }
+      insertShard(&set->shards, &set->size, &set->capacity, set->size, shard);
+    }
+    first = last;
+  }
+}
+
+/**
+ * Fill an empty sharded tree with sorted entries at once, every shard is built without inserting its entries one by
+ * one.
+ * @param set The shards, still empty
+ * @param entries The live entries in strictly increasing order, the shards own the strings afterwards
+ * @param count The amount of entries
+ */
+void buildShards(ShardSet *set, CompactedEntry *entries, int count) {
+  pthread_rwlock_wrlock(&set->lock);
+  buildShardLevel(set, entries, count, SHARD_YEAR);
+  pthread_rwlock_unlock(&set->lock);
+  free(entries);
+}
+
+/**
+ * Replace a range of shards in the directory by the contents of those shards, re-partitioned on a new level.
+ * The caller should hold the directory write lock.
+ * @param set The shards we are re-partitioning
+ * @param first The index of the first shard of the range
+ * @param last The index of the last shard of the range
+ * @param prefixLength The SHARD_* level of the new shards
+ */
+static void repartition(ShardSet *set, int first, int last, int prefixLength) {
+  Shard **shards = NULL;
+  int size = 0;
+  int capacity = 0;
+
+  for (int i = first; i <= last; i++) {
+    Shard *shard = set->shards[i];
+    if (shard->tree->buffered) {
+      flushRange(shard->tree, NULL, NULL);
+    }
+    redistributeNode(set, shard->tree->root, prefixLength, &shards, &size, &capacity);
+    freeFilter(shard->tree->filter);
+    free(shard->tree);
+    pthread_mutex_destroy(&shard->lock);
+    free(shard);
+  }
+
+  int removed = last - first + 1;
+  memmove(&set->shards[first], &set->shards[last + 1], sizeof(Shard *) * (set->size - last - 1));
+  set->size -= removed;
+  for (int i = 0; i < size; i++) {
+    insertShard(&set->shards, &set->size, &set->capacity, first + i, shards[i]);
+  }
+  free(shards);
+}
+
+/**
+ * Split the shard of a date into shards of the next level, if it is still too big.
+ * @param set The shards we are working in
+ * @param date A date in the shard that grew too big
+ */
+static void splitShard(ShardSet *set, char *date) {
+  pthread_rwlock_wrlock(&set->lock);
+  int index = searchShard(set, date, NULL);
+  if (index >= 0) {
+    Shard *shard = set->shards[index];
+    if (shard->tree->size > SHARD_SPLIT_SIZE && shard->prefixLength < SHARD_HOUR) {
+      repartition(set, index, index, nextLevel(shard->prefixLength));
+    }
+  }
+  pthread_rwlock_unlock(&set->lock);
+}
+
+/**
+ * Drop the shard of a date if it is empty, or merge it with its siblings if they became small enough.
+ * @param set The shards we are working in
+ * @param date A date in the shard that shrunk
+ */
+static void mergeShards(ShardSet *set, char *date) {
+  pthread_rwlock_wrlock(&set->lock);
+  int index = searchShard(set, date, NULL);
+  if (index >= 0) {
+    Shard *shard = set->shards[index];
+    // Only a shard without applied entries is flushed to see if it is empty, the siblings use their upper bound
+    if (shardUpperBound(shard) == 0 || (shard->tree->root->recursiveSize == 0 && shardTotal(shard) == 0)) {
+      // Nothing alive anymore, forget about the whole partition
+      retireShard(set, shard);
+      memmove(&set->shards[index], &set->shards[index + 1], sizeof(Shard *) * (set->size - index - 1));
+      set->size--;
+    } else if (shard->prefixLength > SHARD_YEAR) {
+      int parentLength = previousLevel(shard->prefixLength);
+      int first = index;
+      int last = index;
+      while (first > 0 && strncmp(set->shards[first - 1]->prefix, date, parentLength) == 0) first--;
+      while (last + 1 < set->size && strncmp(set->shards[last + 1]->prefix, date, parentLength) == 0) last++;
+
+      int total = 0;
+      int mergeable = 1;
+      for (int i = first; i <= last && mergeable; i++) {
+        mergeable = set->shards[i]->prefixLength == shard->prefixLength;
+        total += shardUpperBound(set->shards[i]);
+      }
+      if (mergeable && total < SHARD_MERGE_SIZE) {
+        repartition(set, first, last, parentLength);
+      }
+    }
+  }
+  pthread_rwlock_unlock(&set->lock);
+}
+
+/**
+ * The loop of the helper thread, which counts one boundary shard of a # at a time.
+ * @param argument The ShardSet the helper works for
+ * @return NULL
+ */
+static void *countHelper(void *argument) {
+  ShardSet *set = argument;
+
+  pthread_mutex_lock(&set->jobLock);
+  while (1) {
+    while (!set->stopping && (set->job.shard == NULL || set->job.done)) {
+      pthread_cond_wait(&set->jobReady, &set->jobLock);
+    }
+    if (set->stopping) break;
+
+    ShardCountJob job = set->job;
+    pthread_mutex_unlock(&set->jobLock);
+
+    pthread_mutex_lock(&job.shard->lock);
+    int count = countBetweenEntries(job.shard->tree, job.begin, job.end);
+    pthread_mutex_unlock(&job.shard->lock);
+
+    pthread_mutex_lock(&set->jobLock);
+    set->job.count = count;
+    set->job.done = 1;
+    pthread_cond_broadcast(&set->jobReady);
+  }
+  pthread_mutex_unlock(&set->jobLock);
+  return NULL;
+}
+
+/**
+ * Count the entries of a shard between begin and end, or all of them if the shard lies within the range.
+ * @param shard The shard we are counting
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The count of entries of the shard between begin and end
+ */
+static int countShard(Shard *shard, char *begin, char *end) {
+  int count;
+  pthread_mutex_lock(&shard->lock);
+  if (compareShard(shard, begin) == 0 || compareShard(shard, end) == 0) {
+    count = countBetweenEntries(shard->tree, begin, end);
+  } else {
+    count = shardTotal(shard);
+  }
+  pthread_mutex_unlock(&shard->lock);
+  return count;
+}
+
+/**
+ * Create a BTree that partitions its entries on time range over independent BTree's.
+ * @return A created sharded BTree
+ */
+BTree *createShardedBTree() {
+  BTree *tree = (BTree *) malloc(sizeof(BTree));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->size = 0;
+  tree->root = NULL;
+  tree->detached.nodes = NULL;
+  tree->detached.size = 0;
+  tree->detached.capacity = 0;
+  tree->firstLeaf = NULL;
+  tree->lastLeaf = NULL;
+  tree->buffered = 0;
+  tree->filter = NULL;
+  tree->bplus = NULL;
+  tree->paged = NULL;
+  tree->hybrid = NULL;
+  tree->compaction = NULL;
+  tree->compactBelow = 0;
+  tree->compactCheck = 0;
+  tree->snapshotDirectory = NULL;
+  tree->shards = createShardSet();
+  if (tree->shards == NULL) {
+    free(tree);
+    return NULL;
+  }
+  return tree;
+}
+
+/**
+ * Create an empty directory of shards.
+ * @return The created ShardSet or NULL if we are out of memory
+ */
+ShardSet *createShardSet() {
+  ShardSet *set = malloc(sizeof(ShardSet));
+  if (set == NULL) {
+    return NULL;
+  }
+  set->shards = NULL;
+  set->size = 0;
+  set->capacity = 0;
+  pthread_rwlock_init(&set->lock, NULL);
+
+  set->stopping = 0;
+  set->job.shard = NULL;
+  set->job.done = 0;
+  pthread_mutex_init(&set->jobLock, NULL);
+  pthread_mutex_init(&set->detachedLock, NULL);
+  set->detached.nodes = NULL;
+  set->detached.size = 0;
+  set->detached.capacity = 0;
+  set->buffered = 0;
+  set->filtered = 0;
+  pthread_cond_init(&set->jobReady, NULL);
+  set->helperStarted = pthread_create(&set->helper, NULL, countHelper, set) == 0;
+  return set;
+}
+
+/**
+ * Free a directory of shards, all shards and their entries.
+ * @param set The ShardSet we want to free
+ */
+void freeShardSet(ShardSet *set) {
+  if (set->helperStarted) {
+    pthread_mutex_lock(&set->jobLock);
+    set->stopping = 1;
+    pthread_cond_broadcast(&set->jobReady);
+    pthread_mutex_unlock(&set->jobLock);
+    pthread_join(set->helper, NULL);
+  }
+  for (int i = 0; i < set->size; i++) {
+    freeShard(set->shards[i]);
+  }
+  free(set->shards);
+  reclaimNodes(&set->detached, -1);
+  free(set->detached.nodes);
+  pthread_rwlock_destroy(&set->lock);
+  pthread_mutex_destroy(&set->jobLock);
+  pthread_mutex_destroy(&set->detachedLock);
+  pthread_cond_destroy(&set->jobReady);
+  free(set);
+}
+
+/**
+ * Insert or overwrite an entry in the shard of its date. Writes on different shards can run concurrently.
+ * @param set The shards where we want to add an entry
+ * @param date The date we want to add
+ * @param description A description of the date
+ */
+void shardedInsertEntry(ShardSet *set, char *date, char *description) {
+  pthread_rwlock_rdlock(&set->lock);
+  int insertAt;
+  int index = searchShard(set, date, &insertAt);
+  if (index < 0) {
+    // There is no partition for this date yet, we need to change the directory
+    pthread_rwlock_unlock(&set->lock);
+    pthread_rwlock_wrlock(&set->lock);
+    index = searchShard(set, date, &insertAt);
+    if (index < 0) {
+      Shard *shard = createShard(set, date, shardLevel(set, date, insertAt));
+      if (shard == NULL) {
+        exit(1);
+      }
+      insertShard(&set->shards, &set->size, &set->capacity, insertAt, shard);
+      index = insertAt;
+    }
+  }
+
+  Shard *shard = set->shards[index];
+  pthread_mutex_lock(&shard->lock);
+  insertEntry(shard->tree, date, description);
+  int split = shard->tree->size > SHARD_SPLIT_SIZE && shard->prefixLength < SHARD_HOUR;
+  // date is freed if it was already in the tree, so we look the shard up with its prefix later on
+  char prefix[DATE];
+  memcpy(prefix, shard->prefix, DATE);
+  pthread_mutex_unlock(&shard->lock);
+  pthread_rwlock_unlock(&set->lock);
+
+  if (split) {
+    splitShard(set, prefix);
+  }
+}
+
+/**
+ * Find the description of an entry in the shards. Another thread can overwrite or remove the entry as soon as the
+ * shard is unlocked, so the description is copied into a buffer of the calling thread.
+ * @param set The shards we are searching in
+ * @param date The key of the entry we are searching
+ * @return The entry description, valid until the next shardedGetEntry on this thread, or NULL if date is not found
+ */
+char *shardedGetEntry(ShardSet *set, char *date) {
+  static _Thread_local char *copy = NULL;
+  static _Thread_local size_t capacity = 0;
+  char *result = NULL;
+
+  pthread_rwlock_rdlock(&set->lock);
+  int index = searchShard(set, date, NULL);
+  if (index >= 0) {
+    Shard *shard = set->shards[index];
+    pthread_mutex_lock(&shard->lock);
+    char *description = getEntry(shard->tree, date);
+    if (description != NULL) {
+      size_t length = strlen(description) + 1;
+      if (length > capacity) {
+        char *grown = realloc(copy, length);
+        if (grown == NULL) {
+          exit(1);
+        }
+        copy = grown;
+        capacity = length;
+      }
+      result = memcpy(copy, description, length);
+    }
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return result;
+}
+
+/**
+ * Remove an entry from the shard of its date.
+ * @param set The shards where we want to remove an entry
+ * @param date The date of the entry we want to remove
+ * @return 0 if failed (date was not in a shard), 1 if succeeded
+ */
+int shardedRemoveEntry(ShardSet *set, char *date) {
+  int status = 0;
+  int shrunk = 0;
+
+  pthread_rwlock_rdlock(&set->lock);
+  int index = searchShard(set, date, NULL);
+  if (index >= 0) {
+    Shard *shard = set->shards[index];
+    pthread_mutex_lock(&shard->lock);
+    status = removeEntry(shard->tree, date);
+    // Only a hint with buffered writes pending, mergeShards looks at the real total
+    int live = shard->tree->root->recursiveSize;
+    shrunk = status && (live == 0 || (live < SHARD_MERGE_SIZE && shard->prefixLength > SHARD_YEAR));
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&set->lock);
+
+  if (shrunk) {
+    mergeShards(set, date);
+  }
+  return status;
+}
+
+/**
+ * Count the entries in the shards between begin and end (both inclusive). Shards within the range only add their
+ * total, the two boundary shards are descended into, in parallel when they are big enough.
+ * @param set The shards where we will be counting
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @return The count of entries between begin and end
+ */
+int shardedCountBetweenEntries(ShardSet *set, char *begin, char *end) {
+  int count = 0;
+
+  pthread_rwlock_rdlock(&set->lock);
+  int insertAt;
+  int first = searchShard(set, begin, &insertAt);
+  if (first < 0) first = insertAt; // begin falls between shards, start at the next one
+  int last = searchShard(set, end, &insertAt);
+  if (last < 0) last = insertAt - 1; // end falls between shards, stop at the previous one
+
+  if (first == last) {
+    count = countShard(set->shards[first], begin, end);
+  } else if (first < last) {
+    Shard *lower = set->shards[first];
+    Shard *upper = set->shards[last];
+
+    int posted = 0;
+    if (set->helperStarted && compareShard(lower, begin) == 0 && compareShard(upper, end) == 0 &&
+        lower->tree->size >= SHARD_PARALLEL_SIZE && upper->tree->size >= SHARD_PARALLEL_SIZE) {
+      // Both boundaries need a descent into a big tree, let the helper do the upper one
+      pthread_mutex_lock(&set->jobLock);
+      if (set->job.shard == NULL) {
+        set->job.shard = upper;
+        set->job.begin = begin;
+        set->job.end = end;
+        set->job.done = 0;
+        pthread_cond_broadcast(&set->jobReady);
+        posted = 1;
+      }
+      pthread_mutex_unlock(&set->jobLock);
+    }
+
+    count += countShard(lower, begin, end);
+    for (int i = first + 1; i < last; i++) {
+      pthread_mutex_lock(&set->shards[i]->lock);
+      count += shardTotal(set->shards[i]);
+      pthread_mutex_unlock(&set->shards[i]->lock);
+    }
+
+    if (posted) {
+      pthread_mutex_lock(&set->jobLock);
+      while (!set->job.done) {
+        pthread_cond_wait(&set->jobReady, &set->jobLock);
+      }
+      count += set->job.count;
+      set->job.shard = NULL;
+      pthread_mutex_unlock(&set->jobLock);
+    } else {
+      count += countShard(upper, begin, end);
+    }
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return count;
+}
+
+/**
+ * Aggregate the entries of all shards between begin and end (both inclusive). The boundary shards are descended,
+ * the shards in between add the aggregate of their root.
+ * @param set The shards we are working in
+ * @param begin The begin boundary
+ * @param end The end boundary
+ * @param aggregate Set to the aggregate over the entries
+ * @return The amount of entries
+ */
+int shardedAggregateBetweenEntries(ShardSet *set, char *begin, char *end, Aggregate *aggregate) {
+  int count = 0;
+  emptyAggregate(aggregate);
+
+  pthread_rwlock_rdlock(&set->lock);
+  int insertAt;
+  int first = searchShard(set, begin, &insertAt);
+  if (first < 0) first = insertAt; // begin falls between shards, start at the next one
+  int last = searchShard(set, end, &insertAt);
+  if (last < 0) last = insertAt - 1; // end falls between shards, stop at the previous one
+
+  for (int i = first; i <= last; i++) {
+    Shard *shard = set->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    if (compareShard(shard, begin) == 0 || compareShard(shard, end) == 0) {
+      Aggregate part;
+      count += aggregateBetweenEntries(shard->tree, begin, end, &part);
+      combineAggregates(aggregate, &part);
+    } else {
+      count += shardTotal(shard);
+      combineAggregates(aggregate, &shard->tree->root->aggregate);
+    }
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return count;
+}
+
+/**
+ * The total amount of live entries in all shards, each shard keeps its own total.
+ * @param set The shards we are counting
+ * @return The total amount of entries
+ */
+int shardedTotal(ShardSet *set) {
+  int total = 0;
+  pthread_rwlock_rdlock(&set->lock);
+  for (int i = 0; i < set->size; i++) {
+    pthread_mutex_lock(&set->shards[i]->lock);
+    total += shardTotal(set->shards[i]);
+    pthread_mutex_unlock(&set->shards[i]->lock);
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return total;
+}
+
+/**
+ * Drop a whole partition at once. Only the directory is changed, the entries are freed later on by shardedReclaim.
+ * @param set The shards we are dropping a partition from
+ * @param prefix The date prefix of the partition, e.g. "2019" or "2019-04"
+ * @return 0 if there is no partition with this prefix, 1 if it is dropped
+ */
+int dropShard(ShardSet *set, char *prefix) {
+  int dropped = 0;
+
+  pthread_rwlock_wrlock(&set->lock);
+  int index = searchShard(set, prefix, NULL);
+  if (index >= 0 && set->shards[index]->prefixLength == (int) strlen(prefix)) {
+    retireShard(set, set->shards[index]);
+    memmove(&set->shards[index], &set->shards[index + 1], sizeof(Shard *) * (set->size - index - 1));
+    set->size--;
+    dropped = 1;
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return dropped;
+}
+
+/**
+ * Remove all entries between start and end from the shards. Shards within the range are dropped as a whole, only
+ * the boundary shards remove a range themselves.
+ * @param set The shards where we want to remove entries
+ * @param start The begin boundary (inclusive), NULL to start at the first entry
+ * @param end The end boundary
+ * @param inclusiveEnd 1 if end itself should be removed too, 0 otherwise
+ * @return The amount of (non-removed) entries that were removed
+ */
+int shardedRemoveRange(ShardSet *set, char *start, char *end, int inclusiveEnd) {
+  int removed = 0;
+
+  pthread_rwlock_wrlock(&set->lock);
+  int insertAt;
+  int first = 0;
+  if (start != NULL && (first = searchShard(set, start, &insertAt)) < 0) first = insertAt;
+  int last = searchShard(set, end, &insertAt);
+  if (last < 0) last = insertAt - 1;
+  if (first > last) {
+    pthread_rwlock_unlock(&set->lock);
+    return 0;
+  }
+
+  int kept = first;
+  for (int i = first; i <= last; i++) {
+    Shard *shard = set->shards[i];
+    if ((start != NULL && compareShard(shard, start) == 0) || compareShard(shard, end) == 0) {
+      // Boundary shard, only a part of it is removed
+      removed += removeRangeBetween(shard->tree, start, end, inclusiveEnd);
+      pthread_mutex_lock(&set->detachedLock);
+      for (int j = 0; j < shard->tree->detached.size; j++) {
+        detachNode(NULL, &set->detached, shard->tree->detached.nodes[j]);
+      }
+      pthread_mutex_unlock(&set->detachedLock);
+      shard->tree->detached.size = 0;
+      if (shardTotal(shard) > 0) {
+        set->shards[kept++] = shard;
+        continue;
+      }
+    } else {
+      removed += shardTotal(shard);
+    }
+    retireShard(set, shard);
+  }
+  memmove(&set->shards[kept], &set->shards[last + 1], sizeof(Shard *) * (set->size - last - 1));
+  set->size -= last + 1 - kept;
+  pthread_rwlock_unlock(&set->lock);
+  return removed;
+}
+
+/**
+ * Visit the first or last live entries in the shards, the shards are visited in order until we have enough.
+ * @param set The shards we are working in
+ * @param last 1 to visit from the last entry backwards, 0 to visit from the first entry on
+ * @param count The amount of entries the visitor should count before we stop
+ * @param visit The visitor
+ * @param context Passed on to the visitor
+ * @return The amount of entries the visitor counted
+ */
+int shardedEdgeEntries(ShardSet *set, int last, int count, EntryVisitor visit, void *context) {
+  int visited = 0;
+
+  pthread_rwlock_rdlock(&set->lock);
+  for (int step = 0; step < set->size && visited < count; step++) {
+    Shard *shard = set->shards[last ? set->size - 1 - step : step];
+    pthread_mutex_lock(&shard->lock);
+    visited += edgeEntries(shard->tree, last, count - visited, visit, context);
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&set->lock);
+  return visited;
+}
+
+/**
+ * Free a bounded amount of the dropped shards and removed ranges.
+ * @param set The shards whose removed nodes we are freeing
+ * @param budget The maximum amount of nodes we may free
+ */
+void shardedReclaim(ShardSet *set, int budget) {
+  pthread_mutex_lock(&set->detachedLock);
+  reclaimNodes(&set->detached, budget);
+  pthread_mutex_unlock(&set->detachedLock);
+}
@@ -0,0 +1,106 @@
+#ifndef BTREE_SHARD_H
+#define BTREE_SHARD_H
+
+#include "btree.h"
+#include "compact.h"
+#include <pthread.h>
+
+// Lengths of the date prefixes a shard can cover: year, month, day and hour
+#define SHARD_YEAR 4
+#define SHARD_MONTH 7
+#define SHARD_DAY 10
+#define SHARD_HOUR 13
+
+#ifndef SHARD_SPLIT_SIZE
+#define SHARD_SPLIT_SIZE (1 << 20) // a shard with more keys than this is split into the next level
+#endif
+#ifndef SHARD_MERGE_SIZE
+#define SHARD_MERGE_SIZE (1 << 14) // sibling shards with less live entries than this are merged again
+#endif
+#ifndef SHARD_PARALLEL_SIZE
+#define SHARD_PARALLEL_SIZE (1 << 16) // boundary shards smaller than this are counted on the calling thread
+#endif
+
+typedef struct Shard Shard;
+
+/**
+ * Struct representing one time partition of a sharded BTree
+ */
+struct Shard {
+    char prefix[DATE]; // The date prefix all keys in this shard start with
+    int prefixLength; // The length of prefix, one of the SHARD_* levels
+    BTree *tree; // The independent BTree holding the entries of this shard
+    pthread_mutex_t lock; // Lock serialising the writes on this shard
+};
+
+/**
+ * Struct representing a boundary count handed to the helper thread
+ */
+typedef struct ShardCountJob {
+    Shard *shard; // The shard that should be counted, NULL if there is no job
+    char *begin; // The begin boundary
+    char *end; // The end boundary
+    int count; // The result of the count
+    int done; // 1 if the count is finished
+} ShardCountJob;
+
+/**
+ * Struct representing the directory of time partitions of a sharded BTree
+ */
+struct ShardSet {
+    Shard **shards; // The shards, sorted on their prefix
+    int size; // The amount of shards
+    int capacity; // The allocated length of shards
+    pthread_rwlock_t lock; // Lock protecting the directory itself (not the shards)
+
+    pthread_t helper; // Thread counting one of the boundary shards of a #
+    int helperStarted; // 1 if helper is running
+    int stopping; // 1 if helper should exit
+    pthread_mutex_t jobLock; // Lock protecting job
+    pthread_cond_t jobReady; // Signalled when a job is posted or finished
+    ShardCountJob job; // The job of the helper thread
+
+    DetachedNodes detached; // Nodes of dropped shards and removed ranges that still have to be freed
+    pthread_mutex_t detachedLock; // Lock protecting detached, so freeing them doesn't need the directory write lock
+    int buffered; // 1 if new shards should be in the write-optimized mode
+    int filtered; // 1 if new shards should get a negative-lookup filter
+};
+
+/*
+ * Functions for the creation and free-ing of sharded BTree's
+ */
+BTree *createShardedBTree();
+
+ShardSet *createShardSet();
+
+void freeShardSet(ShardSet *set);
+
+/*
+ * Functions behind the BTree API for sharded trees
+ */
+void shardedInsertEntry(ShardSet *set, char *date, char *description);
+
+char *shardedGetEntry(ShardSet *set, char *date);
+
+int shardedRemoveEntry(ShardSet *set, char *date);
+
+int shardedCountBetweenEntries(ShardSet *set, char *begin, char *end);
+
+int shardedAggregateBetweenEntries(ShardSet *set, char *begin, char *end, Aggregate *aggregate);
+
+int shardedTotal(ShardSet *set);
+
+int shardedRemoveRange(ShardSet *set, char *start, char *end, int inclusiveEnd);
+
+int shardedEdgeEntries(ShardSet *set, int last, int count, EntryVisitor visit, void *context);
+
+void shardedReclaim(ShardSet *set, int budget);
+
+void buildShards(ShardSet *set, CompactedEntry *entries, int count);
+
+/*
+ * Functions for managing the partitions
+ */
+int dropShard(ShardSet *set, char *prefix);
+
+#endif //BTREE_SHARD_H
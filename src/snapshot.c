@@ -0,0 +1,346 @@
+#include "snapshot.h"
+#include "protocol.h"
+#include "compact.h"
+#include "filter.h"
+#include "shard.h"
+#include "hybrid.h"
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Struct representing a snapshot that is being written, the entries are collected in a block until it is full
+ */
+typedef struct SnapshotWriter {
+    FILE *out; // Where the snapshot goes
+    unsigned char *block; // The payload of the current block
+    size_t size; // The length of the payload
+    size_t capacity; // The allocated length of block
+    uint32_t entries; // The amount of entries in the current block
+    char previous[DATE]; // The date of the last entry in the current block
+    long long total; // The amount of entries written so far
+    int failed; // 1 once a write failed
+} SnapshotWriter;
+
+/**
+ * The CRC-32 (IEEE, as in zip and PNG) of some bytes.
+ * @param bytes The bytes
+ * @param length The amount of bytes
+ * @return The checksum
+ */
+uint32_t crc32(const unsigned char *bytes, size_t length) {
+  static uint32_t table[256];
+  static int filled = 0;
+  if (!filled) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; bit++) {
+        value = value & 1 ? 0xEDB88320U ^ (value >> 1) : value >> 1;
+      }
+      table[i] = value;
+    }
+    filled = 1;
+  }
+  uint32_t crc = 0xFFFFFFFFU;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+/**
+ * Write the current block with its header and start a new one.
+ */
+static void writeBlock(SnapshotWriter *writer) {
+  unsigned char header[SNAPSHOT_BLOCK_HEADER];
+  writeU32(header, writer->entries);
+  writeU32(&header[4], (uint32_t) writer->size);
+  writeU32(&header[8], writer->size > 0 ? crc32(writer->block, writer->size) : 0);
+  if (fwrite(header, 1, SNAPSHOT_BLOCK_HEADER, writer->out) != SNAPSHOT_BLOCK_HEADER ||
+      fwrite(writer->block, 1, writer->size, writer->out) != writer->size) {
+    writer->failed = 1;
+  }
+  writer->size = 0;
+  writer->entries = 0;
+}
+
+/**
+ * Visitor that adds an entry to the current block of a snapshot, only the part of its date that differs from the
+ * date before it is stored.
+ */
+static int writeSnapshotEntry(char *date, char *description, void *context) {
+  SnapshotWriter *writer = context;
+  size_t dateLength = strlen(date);
+  size_t descriptionLength = strlen(description);
+  size_t shared = 0;
+  if (writer->entries > 0) {
+    while (shared < dateLength && date[shared] == writer->previous[shared]) {
+      shared++;
+    }
+  }
+
+  size_t needed = writer->size + 2 + (dateLength - shared) + 4 + descriptionLength;
+  if (needed > writer->capacity) {
+    size_t capacity = writer->capacity * 2 > needed ? writer->capacity * 2 : needed;
+    unsigned char *block = realloc(writer->block, capacity);
+    if (block == NULL) {
+      exit(1);
+    }
+    writer->block = block;
+    writer->capacity = capacity;
+  }
+  unsigned char *position = &writer->block[writer->size];
+  position[0] = (unsigned char) shared;
+  position[1] = (unsigned char) (dateLength - shared);
+  memcpy(&position[2], &date[shared], dateLength - shared);
+  position += 2 + dateLength - shared;
+  writeU32(position, (uint32_t) descriptionLength);
+  memcpy(&position[4], description, descriptionLength);
+  writer->size = needed;
+
+  memcpy(writer->previous, date, dateLength + 1);
+  writer->entries++;
+  writer->total++;
+  if (writer->size >= SNAPSHOT_BLOCK) {
+    writeBlock(writer);
+  }
+  return 1;
+}
+
+/**
+ * Write a snapshot of the live entries of a tree, in order of date.
+ * @param tree The tree, with -b the buffered writes are applied first
+ * @param out Where the snapshot goes, only written front to back so it can be a pipe
+ * @return The amount of entries in the snapshot, -1 if writing failed
+ */
+long long writeSnapshot(BTree *tree, FILE *out) {
+  SnapshotWriter writer;
+  writer.out = out;
+  writer.capacity = SNAPSHOT_BLOCK + 64;
+  writer.block = malloc(writer.capacity);
+  if (writer.block == NULL) {
+    freeBTree(tree);
+    exit(1);
+  }
+  writer.size = 0;
+  writer.entries = 0;
+  writer.total = 0;
+  writer.failed = 0;
+
+  unsigned char header[SNAPSHOT_HEADER];
+  memcpy(header, SNAPSHOT_MAGIC, 4);
+  writeU32(&header[4], SNAPSHOT_VERSION);
+  if (fwrite(header, 1, SNAPSHOT_HEADER, out) != SNAPSHOT_HEADER) {
+    writer.failed = 1;
+  }
+  firstEntries(tree, INT_MAX, writeSnapshotEntry, &writer);
+  if (writer.entries > 0) {
+    writeBlock(&writer);
+  }
+  // The end is a block without entries
+  writeBlock(&writer);
+  free(writer.block);
+  if (fflush(out) != 0 || writer.failed) {
+    return -1;
+  }
+  return writer.total;
+}
+
+/**
+ * Write a snapshot of the live entries of a tree to a file, e.g. for -E.
+ * @param tree The tree
+ * @param path The file or pipe the snapshot goes to, a file is overwritten
+ * @return The amount of entries in the snapshot, -1 if the file can't be opened or written
+ */
+long long saveSnapshot(BTree *tree, char *path) {
+  FILE *out = fopen(path, "wb");
+  if (out == NULL) {
+    return -1;
+  }
+  long long entries = writeSnapshot(tree, out);
+  if (fclose(out) != 0) {
+    return -1;
+  }
+  return entries;
+}
+
+/**
+ * Write a snapshot of the live entries of a tree to a new file in its snapshot directory, for the @ command. Only a
+ * plain name is accepted and the file is created: a client can't write outside the directory or overwrite a file,
+ * and opening never waits on a FIFO without a reader.
+ * @param tree The tree
+ * @param name The name of the file
+ * @return The amount of entries in the snapshot, -1 if @ is turned off, the name is refused or the file can't be
+ * created or written
+ */
+long long saveNamedSnapshot(BTree *tree, char *name) {
+  if (tree->snapshotDirectory == NULL || name[0] == '\0' || strchr(name, '/') != NULL || strcmp(name, ".") == 0 ||
+      strcmp(name, "..") == 0) {
+    return -1;
+  }
+  int directory = open(tree->snapshotDirectory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directory < 0) {
+    return -1;
+  }
+  int file = openat(directory, name, O_WRONLY | O_CREAT | O_EXCL | O_NONBLOCK | O_CLOEXEC, 0644);
+  FILE *out = file >= 0 ? fdopen(file, "wb") : NULL;
+  if (out == NULL) {
+    if (file >= 0) {
+      close(file);
+      unlinkat(directory, name, 0);
+    }
+    close(directory);
+    return -1;
+  }
+  long long entries = writeSnapshot(tree, out);
+  if (fclose(out) != 0) {
+    entries = -1;
+  }
+  if (entries < 0) {
+    // Don't leave a snapshot behind that can't be read
+    unlinkat(directory, name, 0);
+  }
+  close(directory);
+  return entries;
+}
+
+/**
+ * Decode the entries of a block and add them to the entries read so far.
+ * @param payload The payload of the block, its checksum is correct
+ * @param length The length of the payload
+ * @param count The amount of entries in the block
+ * @param entries The entries read so far, grown when needed
+ * @param size The amount of entries read so far
+ * @param capacity The allocated length of entries
+ * @return 1 if the block is valid and its dates come after the ones before, 0 otherwise
+ */
+static int readBlock(unsigned char *payload, size_t length, uint32_t count, CompactedEntry **entries, int *size,
+                     int *capacity) {
+  size_t position = 0;
+  char date[DATE];
+  size_t dateLength = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (position + 2 > length) {
+      return 0;
+    }
+    size_t shared = payload[position];
+    size_t suffix = payload[position + 1];
+    position += 2;
+    if (shared > dateLength || shared + suffix >= DATE || position + suffix + 4 > length) {
+      return 0;
+    }
+    memcpy(&date[shared], &payload[position], suffix);
+    dateLength = shared + suffix;
+    date[dateLength] = '\0';
+    position += suffix;
+    uint32_t descriptionLength = readU32(&payload[position]);
+    position += 4;
+    if (descriptionLength > length - position) {
+      return 0;
+    }
+    if (*size > 0 && strcmp((*entries)[*size - 1].date, date) >= 0) {
+      // Not sorted or a key twice
+      return 0;
+    }
+
+    if (*size == *capacity) {
+      if (*capacity > INT_MAX / 2) {
+        return 0;
+      }
+      *capacity = *capacity > 0 ? *capacity * 2 : 1024;
+      CompactedEntry *grown = realloc(*entries, sizeof(CompactedEntry) * *capacity);
+      if (grown == NULL) {
+        exit(1);
+      }
+      *entries = grown;
+    }
+    // Keys are DATE long everywhere in the tree
+    CompactedEntry *entry = &(*entries)[(*size)++];
+    entry->date = calloc(DATE, sizeof(char));
+    entry->description = malloc(sizeof(char) * (descriptionLength + 1));
+    if (entry->date == NULL || entry->description == NULL) {
+      exit(1);
+    }
+    memcpy(entry->date, date, dateLength);
+    memcpy(entry->description, &payload[position], descriptionLength);
+    entry->description[descriptionLength] = '\0';
+    position += descriptionLength;
+  }
+  return position == length;
+}
+
+/**
+ * Read a snapshot into an empty tree. A tree that keeps its entries in BTreeNode's is built at once out of the
+ * sorted run, like a compaction builds it; the other engines get the entries inserted one by one.
+ * @param tree The tree, empty
+ * @param in Where the snapshot comes from, only read front to back so it can be a pipe
+ * @return The amount of entries read, -1 if the snapshot is cut off or invalid (the tree is left empty)
+ */
+long long readSnapshot(BTree *tree, FILE *in) {
+  unsigned char header[SNAPSHOT_BLOCK_HEADER];
+  if (fread(header, 1, SNAPSHOT_HEADER, in) != SNAPSHOT_HEADER || memcmp(header, SNAPSHOT_MAGIC, 4) != 0 ||
+      readU32(&header[4]) != SNAPSHOT_VERSION) {
+    return -1;
+  }
+
+  CompactedEntry *entries = NULL;
+  int size = 0;
+  int capacity = 0;
+  unsigned char *payload = NULL;
+  size_t payloadCapacity = 0;
+  int valid = 1;
+  while (valid) {
+    if (fread(header, 1, SNAPSHOT_BLOCK_HEADER, in) != SNAPSHOT_BLOCK_HEADER) {
+      valid = 0;
+      break;
+    }
+    uint32_t count = readU32(header);
+    uint32_t length = readU32(&header[4]);
+    if (count == 0) {
+      valid = length == 0;
+      break;
+    }
+    if (length > payloadCapacity) {
+      free(payload);
+      payloadCapacity = length;
+      payload = malloc(payloadCapacity);
+      if (payload == NULL) {
+        exit(1);
+      }
+    }
+    valid = fread(payload, 1, length, in) == length && crc32(payload, length) == readU32(&header[8]) &&
+            readBlock(payload, length, count, &entries, &size, &capacity);
+  }
+  free(payload);
+
+  if (!valid) {
+    for (int i = 0; i < size; i++) {
+      free(entries[i].date);
+      free(entries[i].description);
+    }
+    free(entries);
+    return -1;
+  }
+
+  if (tree->shards == NULL && tree->bplus == NULL && tree->paged == NULL && tree->hybrid == NULL) {
+    buildTree(tree, entries, size);
+    if (tree->filter != NULL) {
+      rebuildFilter(tree);
+    }
+    return size;
+  }
+  if (tree->shards != NULL) {
+    buildShards(tree->shards, entries, size);
+    return size;
+  }
+  if (tree->hybrid != NULL) {
+    buildHybrid(tree->hybrid, entries, size);
+    return size;
+  }
+  // The B+ tree engines insert the entries one by one
+  for (int i = 0; i < size; i++) {
+    insertEntry(tree, entries[i].date, entries[i].description);
+  }
+  free(entries);
+  return size;
+}
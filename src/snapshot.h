@@ -0,0 +1,41 @@
+#ifndef BTREE_SNAPSHOT_H
+#define BTREE_SNAPSHOT_H
+
+#include "btree.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * A snapshot is the sorted run of the live entries of a tree, written and read front to back so it can go through a
+ * pipe. All integers are little-endian.
+ *
+ *  snapshot = "HSNP" | u32 version | block* | end
+ *  block    = u32 entries | u32 length | u32 crc32 of payload | payload (length bytes)
+ *  payload  = entry*, entry = u8 shared | u8 suffix length | suffix | u32 description length | description
+ *  end      = a block of 0 entries and 0 bytes
+ *
+ * shared is the amount of leading characters a date has in common with the date before it in the same block, only
+ * the rest is stored. Every block starts over, so it can be checked and decoded on its own.
+ */
+#define SNAPSHOT_MAGIC "HSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER 8 // length of the magic and version
+#define SNAPSHOT_BLOCK_HEADER 12 // length of the header of a block
+#ifndef SNAPSHOT_BLOCK
+#define SNAPSHOT_BLOCK 65536 // a block is written once its payload reaches this many bytes
+#endif
+
+/*
+ * Functions for writing and reading snapshots
+ */
+uint32_t crc32(const unsigned char *bytes, size_t length);
+
+long long writeSnapshot(BTree *tree, FILE *out);
+
+long long saveSnapshot(BTree *tree, char *path);
+
+long long saveNamedSnapshot(BTree *tree, char *name);
+
+long long readSnapshot(BTree *tree, FILE *in);
+
+#endif //BTREE_SNAPSHOT_H
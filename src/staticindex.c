@@ -0,0 +1,355 @@
+#include "staticindex.h"
+#include "protocol.h"
+#include "aggregate.h"
+
+/**
+ * Place the sorted keys of a subtree of the implicit search tree in Eytzinger order (an in-order walk of it).
+ * @param index The index whose layout we are filling
+ * @param position The position in keys of the first key of the subtree
+ * @param node The node of the subtree in layout, its children are 2 * node and 2 * node + 1
+ * @return The position in keys of the first key after the subtree
+ */
+static int fillLayout(StaticIndex *index, int position, uint32_t node) {
+  if (node > (uint32_t) index->size) {
+    return position;
+  }
+  position = fillLayout(index, position, 2 * node);
+  index->layout[node] = index->keys[position];
+  index->ranks[node] = position;
+  return fillLayout(index, position + 1, 2 * node + 1);
+}
+
+/**
+ * Add to the amount of removed entries of a word, in all sums of the Fenwick tree that cover it.
+ * @param index The index whose sums we are updating
+ * @param word The word of the removed bitmap
+ * @param amount The amount of entries of the word that were removed
+ */
+static void addRemoved(StaticIndex *index, int word, int amount) {
+  for (int i = word + 1; i <= index->words; i += i & -i) {
+    index->removedSums[i] += amount;
+  }
+}
+
+/**
+ * The amount of removed entries in the words in front of a word, out of the log(n) sums of the Fenwick tree.
+ */
+static int removedInFront(StaticIndex *index, int word) {
+  int removed = 0;
+  for (int i = word; i > 0; i -= i & -i) {
+    removed += index->removedSums[i];
+  }
+  return removed;
+}
+
+/**
+ * Rebuild the Fenwick tree out of the bitmap in one pass, cheaper than updating it word by word when a removal
+ * covers a large part of the index.
+ */
+static void rebuildRemovedSums(StaticIndex *index) {
+  for (int i = 1; i <= index->words; i++) {
+    index->removedSums[i] = __builtin_popcountll(index->removed[i - 1]);
+  }
+  for (int i = 1; i <= index->words; i++) {
+    int parent = i + (i & -i);
+    if (parent <= index->words) {
+      index->removedSums[parent] += index->removedSums[i];
+    }
+  }
+}
+
+/**
+ * Add the live entries between two positions to an aggregate, one by one.
+ */
+static void aggregateEntries(StaticIndex *index, int from, int to, Aggregate *aggregate) {
+  for (int position = from; position < to; position++) {
+    if (staticIsLive(index, position)) {
+      addEntryToAggregate(aggregate, index->descriptions[position]);
+    }
+  }
+}
+
+/**
+ * Recalculate the aggregate of a word out of its live entries.
+ */
+static void recalculateWord(StaticIndex *index, int word) {
+  Aggregate *aggregate = &index->aggregates[index->leaves + word];
+  emptyAggregate(aggregate);
+  int last = (word + 1) * STATIC_WORD < index->size ? (word + 1) * STATIC_WORD : index->size;
+  aggregateEntries(index, word * STATIC_WORD, last, aggregate);
+}
+
+/**
+ * Recalculate a node of the segment tree out of its two children.
+ */
+static void recalculateSegment(StaticIndex *index, int node) {
+  index->aggregates[node] = index->aggregates[2 * node];
+  combineAggregates(&index->aggregates[node], &index->aggregates[2 * node + 1]);
+}
+
+/**
+ * Recalculate the nodes of the segment tree above a word, after its aggregate changed.
+ */
+static void recalculateAbove(StaticIndex *index, int word) {
+  for (int node = (index->leaves + word) / 2; node > 0; node /= 2) {
+    recalculateSegment(index, node);
+  }
+}
+
+/**
+ * Create a static index over sorted entries.
+ * @param keys The packed keys, sorted and unique, the index takes them over
+ * @param descriptions The descriptions of the keys, the index takes them over
+ * @param size The amount of entries
+ * @return The created index, NULL if we are out of memory
+ */
+StaticIndex *createStaticIndex(uint64_t *keys, char **descriptions, int size) {
+  StaticIndex *index = malloc(sizeof(StaticIndex));
+  if (index == NULL) {
+    return NULL;
+  }
+  int words = size / STATIC_WORD + 1;
+  index->size = size;
+  index->words = words;
+  index->keys = keys;
+  index->descriptions = descriptions;
+  index->layout = malloc(sizeof(uint64_t) * (size + 1));
+  index->ranks = malloc(sizeof(uint32_t) * (size + 1));
+  index->removed = calloc(words, sizeof(uint64_t));
+  index->removedSums = calloc(words + 1, sizeof(int));
+  index->leaves = 1;
+  while (index->leaves < words) {
+    index->leaves *= 2;
+  }
+  index->aggregates = malloc(sizeof(Aggregate) * 2 * index->leaves);
+  if (index->layout == NULL || index->ranks == NULL || index->removed == NULL || index->removedSums == NULL ||
+      index->aggregates == NULL) {
+    free(index->layout);
+    free(index->ranks);
+    free(index->removed);
+    free(index->removedSums);
+    free(index->aggregates);
+    free(index);
+    return NULL;
+  }
+  fillLayout(index, 0, 1);
+  index->removedCount = 0;
+  for (int word = 0; word < index->leaves; word++) {
+    recalculateWord(index, word);
+  }
+  for (int node = index->leaves - 1; node > 0; node--) {
+    recalculateSegment(index, node);
+  }
+  return index;
+}
+
+/**
+ * Free a static index.
+ * @param index The index we want to free
+ * @param freeLive 1 to free all descriptions, 0 to only free those of removed entries (the others were handed over)
+ */
+void freeStaticIndex(StaticIndex *index, int freeLive) {
+  for (int i = 0; i < index->size; i++) {
+    if (freeLive || !staticIsLive(index, i)) {
+      free(index->descriptions[i]);
+    }
+  }
+  free(index->keys);
+  free(index->descriptions);
+  free(index->layout);
+  free(index->ranks);
+  free(index->removed);
+  free(index->removedSums);
+  free(index->aggregates);
+  free(index);
+}
+
+/**
+ * Search the first key that is at least a packed key. Every step goes one level down the implicit tree, the
+ * comparison only decides which child, so there are no branches to mispredict. The children four levels down share
+ * a cache line and are prefetched.
+ * @param index The index we are searching in
+ * @param key The packed key we are searching
+ * @return The node in layout of the key, 0 if all keys are smaller
+ */
+static uint32_t descend(StaticIndex *index, uint64_t key) {
+  uint32_t node = 1;
+  while (node <= (uint32_t) index->size) {
+    __builtin_prefetch(index->layout + 16 * (size_t) node);
+    node = 2 * node + (index->layout[node] < key);
+  }
+  // Go back up past the right turns, to the last node where we turned left
+  return node >> __builtin_ffs(~node);
+}
+
+/**
+ * The amount of keys that are smaller than (or equal to) a date.
+ * @param index The index we are searching in
+ * @param date The date we are searching
+ * @param upper 1 to count the key equal to date as well, 0 otherwise
+ * @return The position in keys of the first key after those keys
+ */
+int staticBound(StaticIndex *index, char *date, int upper) {
+  uint64_t key;
+  if (packDate(date, &key)) {
+    // The packed keys are at most 14 digits, so key + 1 can't overflow
+    uint32_t node = descend(index, key + upper);
+    return node == 0 ? index->size : (int) index->ranks[node];
+  }
+
+  // Not a date, no key is equal to it so we compare the strings of the sorted keys
+  char unpacked[DATE];
+  int low = 0;
+  int high = index->size;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    unpackDate(index->keys[middle], unpacked);
+    if (strcmp(unpacked, date) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * Find a live entry.
+ * @param index The index we are searching in
+ * @param date The key we are searching
+ * @return The position of the entry in keys, -1 if it is not in the index or removed
+ */
+int staticFind(StaticIndex *index, char *date) {
+  uint64_t key;
+  if (!packDate(date, &key)) {
+    return -1;
+  }
+  uint32_t node = descend(index, key);
+  if (node == 0 || index->layout[node] != key || !staticIsLive(index, (int) index->ranks[node])) {
+    return -1;
+  }
+  return (int) index->ranks[node];
+}
+
+/**
+ * Check if an entry is live.
+ * @param index The index of the entry
+ * @param position The position of the entry in keys
+ * @return 1 if the entry is not removed, 0 otherwise
+ */
+int staticIsLive(StaticIndex *index, int position) {
+  return !(index->removed[position / STATIC_WORD] >> (position % STATIC_WORD) & 1);
+}
+
+/**
+ * The amount of live entries in front of a position.
+ */
+static int liveInFront(StaticIndex *index, int position) {
+  int word = position / STATIC_WORD;
+  uint64_t before = ((uint64_t) 1 << (position % STATIC_WORD)) - 1;
+  return word * STATIC_WORD - removedInFront(index, word) + __builtin_popcountll(~index->removed[word] & before);
+}
+
+/**
+ * Count the live entries between two positions.
+ * @param index The index we are counting in
+ * @param from The first position (inclusive)
+ * @param to The last position (exclusive)
+ * @return The amount of live entries
+ */
+int staticLiveBetween(StaticIndex *index, int from, int to) {
+  if (from >= to) {
+    return 0;
+  }
+  return liveInFront(index, to) - liveInFront(index, from);
+}
+
+/**
+ * Aggregate the live entries between two positions. The words that lie within the range as a whole are combined in
+ * the segment tree, only the entries of the words at both ends are walked.
+ * @param index The index we are aggregating in
+ * @param from The first position (inclusive)
+ * @param to The last position (exclusive)
+ * @param aggregate The aggregate, extended
+ * @return The amount of live entries
+ */
+int staticAggregateBetween(StaticIndex *index, int from, int to, Aggregate *aggregate) {
+  if (from >= to) {
+    return 0;
+  }
+  int firstWord = (from + STATIC_WORD - 1) / STATIC_WORD; // The first word that lies within the range
+  int lastWord = to / STATIC_WORD; // The word after the last one that lies within the range
+  if (firstWord >= lastWord) {
+    // No word lies within the range as a whole
+    aggregateEntries(index, from, to, aggregate);
+    return staticLiveBetween(index, from, to);
+  }
+  aggregateEntries(index, from, firstWord * STATIC_WORD, aggregate);
+  aggregateEntries(index, lastWord * STATIC_WORD, to, aggregate);
+  for (int left = index->leaves + firstWord, right = index->leaves + lastWord; left < right; left /= 2, right /= 2) {
+    if (left & 1) {
+      combineAggregates(aggregate, &index->aggregates[left++]);
+    }
+    if (right & 1) {
+      combineAggregates(aggregate, &index->aggregates[--right]);
+    }
+  }
+  return staticLiveBetween(index, from, to);
+}
+
+/**
+ * Remove an entry, its description stays until the index is freed.
+ * @param index The index of the entry
+ * @param position The position of the entry in keys
+ */
+void staticRemove(StaticIndex *index, int position) {
+  if (staticIsLive(index, position)) {
+    index->removed[position / STATIC_WORD] |= (uint64_t) 1 << (position % STATIC_WORD);
+    index->removedCount++;
+    addRemoved(index, position / STATIC_WORD, 1);
+    int word = position / STATIC_WORD;
+    if (!removeEntryFromAggregate(&index->aggregates[index->leaves + word], index->descriptions[position])) {
+      recalculateWord(index, word);
+    }
+    recalculateAbove(index, word);
+  }
+}
+
+/**
+ * Remove the entries between two positions.
+ * @param index The index we are removing in
+ * @param from The first position (inclusive)
+ * @param to The last position (exclusive)
+ * @return The amount of entries that were live
+ */
+int staticRemoveBetween(StaticIndex *index, int from, int to) {
+  int removed = staticLiveBetween(index, from, to);
+  if (removed == 0) {
+    return 0;
+  }
+  // Updating the sums costs log(n) per word, rebuilding them n
+  int rebuild = (to - from) / STATIC_WORD * (32 - __builtin_clz(index->words)) > index->words;
+  for (int position = from; position < to;) {
+    int word = position / STATIC_WORD;
+    int last = (word + 1) * STATIC_WORD < to ? STATIC_WORD : to - word * STATIC_WORD;
+    uint64_t upto = last == STATIC_WORD ? ~(uint64_t) 0 : ((uint64_t) 1 << last) - 1;
+    uint64_t before = index->removed[word];
+    index->removed[word] |= upto & ~(((uint64_t) 1 << (position % STATIC_WORD)) - 1);
+    if (index->removed[word] != before) {
+      recalculateWord(index, word);
+    }
+    if (!rebuild) {
+      addRemoved(index, word, __builtin_popcountll(index->removed[word] & ~before));
+      recalculateAbove(index, word);
+    }
+    position = (word + 1) * STATIC_WORD;
+  }
+  if (rebuild) {
+    rebuildRemovedSums(index);
+    for (int node = index->leaves - 1; node > 0; node--) {
+      recalculateSegment(index, node);
+    }
+  }
+  index->removedCount += removed;
+  return removed;
+}
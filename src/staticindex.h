@@ -0,0 +1,57 @@
+#ifndef BTREE_STATICINDEX_H
+#define BTREE_STATICINDEX_H
+
+#include "btree.h"
+#include <stdint.h>
+
+#define STATIC_WORD 64 // amount of entries one word of the removed bitmap covers
+
+/**
+ * Struct representing a frozen, read-optimized index over a sorted array of entries. The keys are packed dates, kept
+ * in sorted order and a second time in Eytzinger order (the breadth-first order of a complete binary search tree), so
+ * a search walks down one array without branches and the next levels are prefetched. Entries are never added, a
+ * removal only sets a bit. The removed entries of every word of the bitmap are summed in a Fenwick tree, so a count is
+ * two searches and two prefix sums, and a removal only updates the log(n) sums that cover its word. The aggregates
+ * over the live entries of every word are combined in a segment tree, so an aggregate only walks the entries of the
+ * two words at the boundaries.
+ */
+typedef struct StaticIndex {
+    int size; // The amount of entries, live or removed
+    uint64_t *keys; // The packed keys, sorted
+    char **descriptions; // The descriptions, in the order of keys
+    uint64_t *layout; // The packed keys in Eytzinger order, layout[1] is the root and layout[0] is unused
+    uint32_t *ranks; // The position in keys of every key in layout
+    uint64_t *removed; // Bitmap with a bit set for every removed entry
+    int words; // The amount of words of removed
+    int *removedSums; // Fenwick tree over the amount of removed entries in every word, removedSums[0] is unused
+    int removedCount; // The amount of removed entries
+    Aggregate *aggregates; // Segment tree over the aggregates of the live entries of every word, aggregates[1] is the
+                           // root and aggregates[leaves + w] the aggregate of word w
+    int leaves; // The amount of leaves of the segment tree, a power of two of at least words
+} StaticIndex;
+
+/*
+ * Functions for the creation and free-ing of static indexes
+ */
+StaticIndex *createStaticIndex(uint64_t *keys, char **descriptions, int size);
+
+void freeStaticIndex(StaticIndex *index, int freeLive);
+
+/*
+ * Functions for searching and removing in static indexes
+ */
+int staticBound(StaticIndex *index, char *date, int upper);
+
+int staticFind(StaticIndex *index, char *date);
+
+int staticIsLive(StaticIndex *index, int position);
+
+int staticLiveBetween(StaticIndex *index, int from, int to);
+
+int staticAggregateBetween(StaticIndex *index, int from, int to, Aggregate *aggregate);
+
+void staticRemove(StaticIndex *index, int position);
+
+int staticRemoveBetween(StaticIndex *index, int from, int to);
+
+#endif //BTREE_STATICINDEX_H
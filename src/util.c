@@ -122,4 +122,124 @@ BTreeNode *binarySearch(BTreeNode *node, char *search, int add, int recursive) {
   }
   // hier komen we alleen als add == 0, wil zeggen dat de entry in geen enkele top gevonden is
   return NULL;
-}
\ No newline at end of file
+}
+
+/**
+ * Search the first index in a node whose key is not smaller than (or, if upper, larger than) a key.
+ * @param node The node we are searching in
+ * @param search The key we are searching
+ * @param upper 0: first key >= search, 1: first key > search
+ * @return An index between 0 and node->size (both inclusive)
+ */
+int boundIndex(BTreeNode *node, char *search, int upper) {
+  int start = 0;
+  int stop = node->size;
+  while (start < stop) {
+    int mid = (start + stop) / 2;
+    int cmp = strcmp(node->dateKeys[mid], search);
+    if (cmp < 0 || (upper && cmp == 0)) {
+      start = mid + 1;
+    } else {
+      stop = mid;
+    }
+  }
+  return start;
+}
+
+/**
+ * Fill a node with a slice of sorted entries and their children.
+ * @param node The node we are filling
+ * @param keys The keys of the entries
+ * @param descriptions The descriptions of the entries
+ * @param children The children around the entries, ignored for leafs
+ * @param from The index of the first entry of the slice
+ * @param size The amount of entries in the slice
+ */
+static void fillNode(BTreeNode *node, char **keys, char **descriptions, BTreeNode **children, int from, int size) {
+  for (int i = 0; i < N; i++) {
+    node->dateKeys[i] = i < size ? keys[from + i] : NULL;
+    node->descriptionValues[i] = i < size ? descriptions[from + i] : NULL;
+  }
+  for (int i = 0; i <= N; i++) {
+    node->childNodes[i] = !node->leaf && i <= size ? children[from + i] : NULL;
+    if (node->childNodes[i] != NULL) {
+      node->childNodes[i]->parent = node;
+    }
+  }
+  node->size = size;
+  node->recursiveSize = -1;
+}
+
+/**
+ * Put a sorted list of up to 2 * N + 1 entries (and their children) in a node. If they don't fit in one node, they
+ * are split over left and a new right node and the entry in the middle is given back as separator.
+ * @param left The node we are filling, its current contents are overwritten
+ * @param keys The keys of the entries
+ * @param descriptions The descriptions of the entries
+ * @param children The total + 1 children around the entries, ignored for leafs
+ * @param total The amount of entries
+ * @param separatorKey Where the key of the separator is stored if we needed a right node
+ * @param separatorDescription "-" the description "-"
+ * @return NULL if all entries fit in left, the new right node otherwise
+ */
+BTreeNode *distributeEntries(BTreeNode *left, char **keys, char **descriptions, BTreeNode **children, int total,
+                             char **separatorKey, char **separatorDescription) {
+  if (total <= N) {
+    fillNode(left, keys, descriptions, children, 0, total);
+    return NULL;
+  }
+
+  BTreeNode *right = createBTreeNode(left->leaf);
+  if (right == NULL) {
+    exit(1);
+  }
+  int mid = total / 2;
+  fillNode(left, keys, descriptions, children, 0, mid);
+  *separatorKey = keys[mid];
+  *separatorDescription = descriptions[mid];
+  fillNode(right, keys, descriptions, children, mid + 1, total - mid - 1);
+  return right;
+}
+
+/**
+ * Remove an entry and one of the children next to it from a node, without free-ing them.
+ * @param node The node we are removing from
+ * @param keyIndex The index of the entry
+ * @param childIndex The index of the child, keyIndex or keyIndex + 1
+ */
+void removeKeyAndChild(BTreeNode *node, int keyIndex, int childIndex) {
+  for (int i = keyIndex; i < node->size - 1; i++) {
+    node->dateKeys[i] = node->dateKeys[i + 1];
+    node->descriptionValues[i] = node->descriptionValues[i + 1];
+  }
+  node->dateKeys[node->size - 1] = NULL;
+  node->descriptionValues[node->size - 1] = NULL;
+  if (!node->leaf) {
+    for (int i = childIndex; i < node->size; i++) {
+      node->childNodes[i] = node->childNodes[i + 1];
+    }
+    node->childNodes[node->size] = NULL;
+  }
+  node->size--;
+}
+
+/**
+ * Insert an entry and the child right of it in a node that still has room for it.
+ * @param node The node we are inserting in
+ * @param keyIndex The index the entry should get
+ * @param date The key of the entry
+ * @param description The description of the entry
+ * @param child The child that should come right of the entry
+ */
+void insertKeyAndChild(BTreeNode *node, int keyIndex, char *date, char *description, BTreeNode *child) {
+  for (int i = node->size; i > keyIndex; i--) {
+    node->dateKeys[i] = node->dateKeys[i - 1];
+    node->descriptionValues[i] = node->descriptionValues[i - 1];
+    node->childNodes[i + 1] = node->childNodes[i];
+  }
+  node->dateKeys[keyIndex] = date;
+  node->descriptionValues[keyIndex] = description;
+  node->childNodes[keyIndex + 1] = child;
+  child->parent = node;
+  node->size++;
+}
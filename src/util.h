@@ -15,4 +15,13 @@ addNode(BTreeNode *to, char *date, char *description, BTreeNode *lChild, BTreeNo
 
 BTreeNode *binarySearch(BTreeNode *node, char *search, int add, int recursive);
 
+int boundIndex(BTreeNode *node, char *search, int upper);
+
+BTreeNode *distributeEntries(BTreeNode *left, char **keys, char **descriptions, BTreeNode **children, int total,
+                             char **separatorKey, char **separatorDescription);
+
+void removeKeyAndChild(BTreeNode *node, int keyIndex, int childIndex);
+
+void insertKeyAndChild(BTreeNode *node, int keyIndex, char *date, char *description, BTreeNode *child);
+
 #endif //BTREE_UTIL_H
\ No newline at end of file
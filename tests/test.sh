@@ -1,15 +1,238 @@
 #!/bin/bash
 
 cd ../src/
+# Small partitions, so the tests split and merge them all the time, and every # with two boundary partitions counts
+# one of them on the helper thread
+make clean history DEFINES="-DSHARD_SPLIT_SIZE=40 -DSHARD_MERGE_SIZE=12 -DSHARD_PARALLEL_SIZE=1"
+cp ./history ../tests/tempsharded
+# Small buffers, so the writes are pushed down through every level
+make clean history DEFINES="-DMESSAGE_BUFFER=4"
+cp ./history ../tests/tempbuffered
+# A small delta, so the tests merge it into the static index all the time
+make clean history DEFINES="-DHYBRID_DELTA=64 -DHYBRID_RATIO=2"
+cp ./history ../tests/temphybrid
+# Small nodes, so the tests split, merge, cut out and compact nodes on every level
+make clean history DEFINES="-DN=4 -DBPLUS_FANOUT=4 -DBPLUS_LEAF=2 -DPAGED_FANOUT=4 -DPAGED_LEAF=4"
+cp ./history ../tests/tempsmall
+# Small nodes, so the generic tree splits at every level
+make clean genhistory DEFINES="-DNANOTREE_ORDER=3"
+cp ./genhistory ../tests/tempgenericsmall
 make clean all
 cp ./history ../tests/temphistory
+cp ./convert ../tests/tempconvert
+cp ./genhistory ../tests/tempgeneric
 cd ../tests
 
-for file in *.in.txt
-do
-  echo "Running test on file: $file"
-  ./temphistory < $file > temp
-  diff -w temp $(echo $file | sed "s/.in/.out/g") | grep "^>" | wc -l
-done
+# Run all tests with a command, print the amount of wrong lines per test
+runTests() {
+  echo "Running tests with: $*"
+  for file in *.in.txt
+  do
+    if grep -q "^%" $file; then
+      # The fill depends on the engine, fillTests runs these
+      continue
+    fi
+    echo "Running test on file: $file"
+    "$@" < $file > temp
+    diff -w temp $(echo $file | sed "s/.in/.out/g") | grep "^>" | wc -l
+  done
+}
 
-rm temphistory temp
\ No newline at end of file
+# Run the tests that print the fill (%) of the plain tree with a command, print the amount of wrong lines per test
+fillTests() {
+  echo "Running fill tests with: $*"
+  for file in *.in.txt
+  do
+    if ! grep -q "^%" $file; then
+      continue
+    fi
+    echo "Running fill test on file: $file"
+    "$@" < $file > temp
+    diff -w temp $(echo $file | sed "s/.in/.out/g") | grep "^>" | wc -l
+  done
+}
+
+# Start a compaction (*) halfway through every test with a command. It runs next to the commands after it and
+# shouldn't change any answer, print the amount of wrong lines per test
+compactTests() {
+  echo "Running compaction tests with: $*"
+  for file in *.in.txt
+  do
+    if grep -q "^%" $file; then
+      continue
+    fi
+    echo "Running compaction test on file: $file"
+    local half=$(( $(wc -l < $file) / 2 ))
+    (head -n $half $file; echo "*"; tail -n +$(( half + 1 )) $file) | "$@" > temp
+    diff -w temp $(echo $file | sed "s/.in/.out/g") | grep "^>" | wc -l
+  done
+}
+
+# Run the tests with only +, -, ? and # commands with a command, print the amount of wrong lines per test
+runGenericTests() {
+  echo "Running generic tests with: $*"
+  for file in *.in.txt
+  do
+    if grep -q "^[^-+?#]" $file; then
+      continue
+    fi
+    echo "Running generic test on file: $file"
+    "$@" < $file > temp
+    diff -w temp $(echo $file | sed "s/.in/.out/g") | grep "^>" | wc -l
+  done
+}
+
+# Write a snapshot with @ after the commands of every test and one with -E at the end, then import it and write it
+# again, the three snapshots should be the same (prints the amount of snapshots that differ)
+snapshotTests() {
+  echo "Running snapshot tests with: $*"
+  for file in *.in.txt
+  do
+    echo "Running snapshot test on file: $file"
+    (sed '$a\' $file; echo "@tempsnapshot") | "$@" -S . -E tempexport > /dev/null
+    "$@" -I tempexport -E tempimport < /dev/null
+    echo $(( $(cmp -s tempsnapshot tempexport || echo 1) + $(cmp -s tempexport tempimport || echo 1) + 0 ))
+    rm tempsnapshot tempexport tempimport
+  done
+}
+
+# Run history with the binary protocol, the commands are sent in frames of 100 commands and the answers turned back
+# into text
+binaryHistory() {
+  ./tempconvert -b -n 100 | ./temphistory -B "$@" | ./tempconvert -a
+}
+
+# Run history in server mode, a client sends the commands over the socket while it reads the answers
+serverHistory() {
+  ./temphistory -l tempsocket "$@" < /dev/null &
+  local server=$!
+  while [ ! -S tempsocket ]
+  do
+    sleep 0.1
+  done
+  python3 -c '
+import socket, sys, threading
+client = socket.socket(socket.AF_UNIX)
+client.connect(sys.argv[1])
+def send():
+    client.sendall(sys.stdin.buffer.read())
+    client.shutdown(socket.SHUT_WR)
+sender = threading.Thread(target=send)
+sender.start()
+while True:
+    answers = client.recv(65536)
+    if not answers:
+        break
+    sys.stdout.buffer.write(answers)
+sender.join()
+' tempsocket
+  kill $server
+  wait $server
+}
+
+# Run a test over 4 clients of a server at the same time. A client gets the +, - and ? commands on the years with
+# the same remainder of 4, so its answers don't depend on how the server interleaves the clients. The # commands are
+# sent afterwards, on the final state. Prints the amount of wrong answers.
+concurrentServerTests() {
+  echo "Running concurrent server tests with: $*"
+  for file in *.in.txt
+  do
+    if grep -q "^[^-+?#]" $file; then
+      continue
+    fi
+    echo "Running concurrent server test on file: $file"
+    for client in 0 1 2 3
+    do
+      awk -v client=$client '/^[-+?]/ && substr($0, 2, 4) % 4 == client' $file > tempclient$client
+    done
+    grep "^#" $file > tempcounts
+
+    "$@" -l tempsocket < /dev/null &
+    local server=$!
+    while [ ! -S tempsocket ]
+    do
+      sleep 0.1
+    done
+    python3 -c '
+import socket, sys, threading
+def run(commands, answers):
+    client = socket.socket(socket.AF_UNIX)
+    client.connect(sys.argv[1])
+    def send():
+        with open(commands, "rb") as source:
+            client.sendall(source.read())
+        client.shutdown(socket.SHUT_WR)
+    sender = threading.Thread(target=send)
+    sender.start()
+    with open(answers, "wb") as target:
+        while True:
+            data = client.recv(65536)
+            if not data:
+                break
+            target.write(data)
+    sender.join()
+clients = [threading.Thread(target=run, args=("tempclient%d" % i, "tempanswers%d" % i)) for i in range(4)]
+for client in clients:
+    client.start()
+for client in clients:
+    client.join()
+run("tempcounts", "tempanswers4")
+' tempsocket
+    kill $server
+    wait $server
+
+    local wrong=0
+    for client in 0 1 2 3
+    do
+      wrong=$(( wrong + $(./temphistory < tempclient$client | diff -w tempanswers$client - | grep -c "^>") ))
+    done
+    cat tempclient0 tempclient1 tempclient2 tempclient3 tempcounts | ./temphistory | tail -n $(wc -l < tempcounts) > temp
+    echo $(( wrong + $(diff -w tempanswers4 temp | grep -c "^>") ))
+  done
+  rm tempclient* tempanswers* tempcounts
+}
+
+runTests ./temphistory
+runTests ./temphistory -s
+runTests ./tempsharded -s
+runTests ./temphistory -b
+runTests ./tempbuffered -b
+runTests ./tempbuffered -s -b
+runTests ./temphistory -f
+runTests ./tempbuffered -s -b -f
+runTests ./temphistory -c 95
+runTests ./tempsmall
+runTests ./tempsmall -b
+runTests ./tempsmall -f -c 95
+runTests ./tempsmall -p
+runTests ./tempsmall -P temppages
+runTests ./tempbuffered -b -c 95
+runTests binaryHistory
+runTests binaryHistory -s -b
+runTests serverHistory
+runTests serverHistory -s -b -f
+concurrentServerTests ./tempsharded -s
+concurrentServerTests ./tempbuffered -s -b -f
+fillTests ./temphistory
+fillTests ./temphistory -f
+fillTests binaryHistory
+fillTests serverHistory
+compactTests ./temphistory
+compactTests ./tempbuffered -b -f
+compactTests binaryHistory
+compactTests ./temphistory -s
+compactTests ./tempsmall
+runTests ./temphistory -p
+runTests ./temphistory -P temppages
+runTests ./temphistory -P temppages -m 8
+runTests ./temphistory -H
+runTests ./temphybrid -H
+runGenericTests ./tempgeneric
+runGenericTests ./tempgenericsmall
+snapshotTests ./temphistory
+snapshotTests ./tempbuffered -s -b -f
+snapshotTests ./tempsharded -s
+snapshotTests ./temphistory -p
+snapshotTests ./temphybrid -H
+
+rm temphistory tempconvert tempsharded tempbuffered temphybrid tempsmall tempgeneric tempgenericsmall temp